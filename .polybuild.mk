@@ -28,32 +28,128 @@ endif
 c_compiler := $(CC)
 cpp_compiler := clang++
 c_compilation_flags := $(CFLAGS) $(dynamic_flag)
-cpp_compilation_flags := -Wall -O3 -std=c++23 $(dynamic_flag)
+cpp_compilation_flags := -Wall -O3 -std=c++23 -pthread $(dynamic_flag)
 link_time_flags := $(LDFLAGS)
-libraries :=
+libraries := $(library_flag)z
 
 all: a.out$(out_ext)
 .PHONY: all
 
-obj/token_0$(obj_ext): src/token.cpp .polybuild.mk src/token.hpp src/syntax.hpp src/value.hpp src/util.hpp
+obj/token_0$(obj_ext): src/token.cpp .polybuild.mk src/token.hpp src/options.hpp src/object.hpp src/key.hpp src/syntax.hpp src/value.hpp src/util.hpp src/simd.hpp
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
 	@mkdir -p obj
 	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
 
-obj/value_0$(obj_ext): src/value.cpp .polybuild.mk src/value.hpp src/util.hpp src/syntax.hpp
+obj/value_0$(obj_ext): src/value.cpp .polybuild.mk src/value.hpp src/object.hpp src/key.hpp src/util.hpp src/simd.hpp src/syntax.hpp src/writer.hpp
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
 	@mkdir -p obj
 	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
 
-obj/sjson_0$(obj_ext): src/sjson.cpp .polybuild.mk src/sjson.hpp src/listener.hpp src/syntax.hpp src/util.hpp src/value.hpp src/token.hpp
+obj/sjson_0$(obj_ext): src/sjson.cpp .polybuild.mk src/sjson.hpp src/cache.hpp src/cbor.hpp src/value.hpp src/object.hpp src/key.hpp src/cursor.hpp src/options.hpp src/simd.hpp src/skip.hpp src/tape.hpp src/token.hpp src/syntax.hpp src/events.hpp src/lexer.hpp src/util.hpp src/file.hpp src/generator.hpp src/gzip.hpp src/readahead.hpp src/listener.hpp src/parallel.hpp src/pool.hpp src/writer.hpp
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
 	@mkdir -p obj
 	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
 
-objects :=  obj/token_0$(obj_ext) obj/value_0$(obj_ext) obj/sjson_0$(obj_ext)
+obj/simd_0$(obj_ext): src/simd.cpp .polybuild.mk src/simd.hpp src/syntax.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/object_0$(obj_ext): src/object.cpp .polybuild.mk src/object.hpp src/key.hpp src/value.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/key_0$(obj_ext): src/key.cpp .polybuild.mk src/key.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/writer_0$(obj_ext): src/writer.cpp .polybuild.mk src/writer.hpp src/value.hpp src/object.hpp src/key.hpp src/util.hpp src/simd.hpp src/syntax.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/skip_0$(obj_ext): src/skip.cpp .polybuild.mk src/skip.hpp src/simd.hpp src/syntax.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/events_0$(obj_ext): src/events.cpp .polybuild.mk src/events.hpp src/lexer.hpp src/simd.hpp src/syntax.hpp src/token.hpp src/options.hpp src/object.hpp src/key.hpp src/value.hpp src/util.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/lexer_0$(obj_ext): src/lexer.cpp .polybuild.mk src/lexer.hpp src/simd.hpp src/syntax.hpp src/token.hpp src/options.hpp src/object.hpp src/key.hpp src/value.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/cursor_0$(obj_ext): src/cursor.cpp .polybuild.mk src/cursor.hpp src/options.hpp src/object.hpp src/key.hpp src/simd.hpp src/skip.hpp src/tape.hpp src/token.hpp src/syntax.hpp src/value.hpp src/lexer.hpp src/sjson.hpp src/cache.hpp src/cbor.hpp src/events.hpp src/util.hpp src/file.hpp src/generator.hpp src/gzip.hpp src/readahead.hpp src/listener.hpp src/parallel.hpp src/pool.hpp src/writer.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/parallel_0$(obj_ext): src/parallel.cpp .polybuild.mk src/parallel.hpp src/listener.hpp src/key.hpp src/syntax.hpp src/token.hpp src/options.hpp src/object.hpp src/value.hpp src/util.hpp src/simd.hpp src/pool.hpp src/sjson.hpp src/cache.hpp src/cbor.hpp src/cursor.hpp src/skip.hpp src/tape.hpp src/events.hpp src/lexer.hpp src/file.hpp src/generator.hpp src/gzip.hpp src/readahead.hpp src/writer.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/pool_0$(obj_ext): src/pool.cpp .polybuild.mk src/pool.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/file_0$(obj_ext): src/file.cpp .polybuild.mk src/file.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/readahead_0$(obj_ext): src/readahead.cpp .polybuild.mk src/readahead.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/gzip_0$(obj_ext): src/gzip.cpp .polybuild.mk src/gzip.hpp src/lexer.hpp src/simd.hpp src/syntax.hpp src/token.hpp src/options.hpp src/object.hpp src/key.hpp src/value.hpp src/readahead.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/cbor_0$(obj_ext): src/cbor.cpp .polybuild.mk src/cbor.hpp src/value.hpp src/object.hpp src/key.hpp src/sjson.hpp src/cache.hpp src/cursor.hpp src/options.hpp src/simd.hpp src/skip.hpp src/tape.hpp src/token.hpp src/syntax.hpp src/events.hpp src/lexer.hpp src/util.hpp src/file.hpp src/generator.hpp src/gzip.hpp src/readahead.hpp src/listener.hpp src/parallel.hpp src/pool.hpp src/writer.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/tape_0$(obj_ext): src/tape.cpp .polybuild.mk src/tape.hpp src/events.hpp src/lexer.hpp src/simd.hpp src/syntax.hpp src/token.hpp src/options.hpp src/object.hpp src/key.hpp src/value.hpp src/util.hpp src/file.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+obj/cache_0$(obj_ext): src/cache.cpp .polybuild.mk src/cache.hpp src/file.hpp src/options.hpp src/object.hpp src/key.hpp src/tape.hpp src/events.hpp src/lexer.hpp src/simd.hpp src/syntax.hpp src/token.hpp src/value.hpp src/util.hpp
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Compiling $@ from $<..."
+	@mkdir -p obj
+	@"$(cpp_compiler)" $(compile_only_flag) $< $(cpp_compilation_flags) $(obj_path_flag)$@
+	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Finished compiling $@ from $<!"
+
+objects :=  obj/token_0$(obj_ext) obj/value_0$(obj_ext) obj/sjson_0$(obj_ext) obj/simd_0$(obj_ext) obj/object_0$(obj_ext) obj/key_0$(obj_ext) obj/writer_0$(obj_ext) obj/skip_0$(obj_ext) obj/events_0$(obj_ext) obj/lexer_0$(obj_ext) obj/cursor_0$(obj_ext) obj/parallel_0$(obj_ext) obj/pool_0$(obj_ext) obj/file_0$(obj_ext) obj/readahead_0$(obj_ext) obj/gzip_0$(obj_ext) obj/cbor_0$(obj_ext) obj/tape_0$(obj_ext) obj/cache_0$(obj_ext)
 a.out$(out_ext): .polybuild.mk $(objects) $(static_libraries)
 	@printf "\033[1m[POLYBUILD]\033[0m %s\n" "Building $@..."
 	@"$(cpp_compiler)" $(objects) $(static_libraries) $(cpp_compilation_flags) $(out_path_flag)$@ $(link_flag) $(link_time_flags) $(libraries)
@@ -0,0 +1,9 @@
+// examples/bench.cpp
+#include "../src/bench.hpp"
+#include "util.hpp"
+
+int main() {
+    // Run all SJSON benchmarks
+    SJSON::Bencher bench;
+    return 0;
+}
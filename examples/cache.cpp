@@ -0,0 +1,24 @@
+// examples/cache.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <filesystem>
+#include <fstream>
+
+int main() {
+    const auto source = std::filesystem::temp_directory_path() / "sjson_example.json";
+    const auto cache = std::filesystem::temp_directory_path() / "sjson_example.tape";
+    {
+        std::ofstream out(source, std::ios::binary);
+        out << input_example;
+    }
+
+    // The first start-up parses and saves the tape, every one after that maps it back without parsing
+    for (int start = 0; start < 2; start++) {
+        const auto doc = SJSON::CachedTape::open(source.string(), cache.string());
+        std::cout << (doc.rebuilt() ? "Parsed: " : "Mapped: ") << doc.to_string() << '\n';
+    }
+
+    std::filesystem::remove(source);
+    std::filesystem::remove(cache);
+    return 0;
+}
@@ -0,0 +1,19 @@
+// examples/cbor.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+
+int main() {
+    // Written once, say to a cache file
+    const std::string bytes = SJSON::CBORWriter::to_string(SJSON::Parse::string(input_example));
+    std::cout << "CBOR is " << bytes.size() << " bytes\n";
+
+    // Listeners work the same as they do on JSON
+    SJSON::Parse json({.drop_generics = true, .format = SJSON::Format::CBOR});
+    json.listen("test[]", [](const SJSON::JSValue& value) {
+        std::cout << "Element: " << value.to_string() << '\n';
+    });
+    json.feed(bytes).finish();
+
+    std::cout << "Whole document: " << json.to_string() << '\n';
+    return 0;
+}
@@ -0,0 +1,19 @@
+// examples/cursor.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+
+int main() {
+    // The buffer has to outlive the cursor, nothing is lexed until it's asked for
+    SJSON::Cursor doc(input_example);
+    auto test = doc.root().get_object()["test"].get_array();
+
+    // Read the first element, the second one is skipped over without being parsed
+    auto it = test.begin();
+    std::cout << "First element: " << (*it).get_int64() << '\n';
+    ++it;
+    ++it;
+
+    // Look up a member of the third element
+    std::cout << "Member 'a' of the third element: " << (*it).get_object()["a"].get_int64() << '\n';
+    return 0;
+}
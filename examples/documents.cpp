@@ -0,0 +1,20 @@
+// examples/documents.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+
+int main() {
+    // JSON Lines with a broken record in the middle
+    const std::string lines = "{\"id\":1}\n{\"id\":}\n{\"id\":3}\n";
+
+    // Every root value goes to the callback, the next one reuses the parser
+    SJSON::Parse json(SJSON::ParseOptions {.multi_document = true});
+    json.documents([](const SJSON::JSValue& value) {
+        std::cout << "Document: " << value.to_string() << '\n';
+    });
+    // Without this the broken record would throw and end the whole stream
+    json.resync([](const SJSON::sjson_parse_error& err) {
+        std::cout << "Skipped a line: " << err.what() << '\n';
+    });
+    json.feed(lines).finish();
+    return 0;
+}
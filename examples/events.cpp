@@ -0,0 +1,30 @@
+// examples/events.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <charconv>
+
+// Sums every number and remembers the deepest nesting without building any values
+class Summer : public SJSON::Handler {
+public:
+    double sum = 0;
+    size_t depth = 0;
+    size_t deepest = 0;
+
+    void start_object() override { deepest = std::max(deepest, ++depth); }
+    void end_object() override { depth--; }
+    void start_array() override { deepest = std::max(deepest, ++depth); }
+    void end_array() override { depth--; }
+    void number(std::string_view src) override {
+        double value = 0;
+        std::from_chars(src.data(), src.data() + src.size(), value);
+        sum += value;
+    }
+};
+
+int main() {
+    Summer summer;
+    SJSON::Events::stream(std::move(stream_example), summer);
+    std::cout << "Sum of every number: " << summer.sum << '\n'
+              << "Deepest nesting: " << summer.deepest << '\n';
+    return 0;
+}
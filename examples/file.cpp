@@ -0,0 +1,24 @@
+// examples/file.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <filesystem>
+#include <fstream>
+
+int main() {
+    const auto path = std::filesystem::temp_directory_path() / "sjson_example.json";
+    std::ofstream(path) << input_example;
+
+    // The file is mapped instead of read, nothing is copied out of it
+    std::cout << "Whole file: " << SJSON::Parse::file(path.string()).to_string() << '\n';
+
+    // Pages that were parsed are given back as it goes, so files bigger than RAM work too as long as what's kept fits
+    SJSON::MappedFile file(path.string());
+    SJSON::Parse json(SJSON::ParseOptions {.drop_generics = true});
+    json.listen("test[]", [](const SJSON::JSValue& value) {
+        std::cout << "Element: " << value.to_string() << '\n';
+    });
+    json.feed(file).finish();
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,19 @@
+// examples/gzip.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <sstream>
+
+int main() {
+    // Stands in for an std::ifstream of a .json.gz archive
+    std::istringstream archive(SJSON::gzip(input_example));
+
+    // Inflated 64 KiB at a time straight into the parser, the archive is never decompressed as a whole
+    SJSON::Parse json;
+    json.listen("test[]", [](const SJSON::JSValue& value) {
+        std::cout << "Element: " << value.to_string() << '\n';
+    });
+    json.feed(SJSON::GzipReader(SJSON::istream_reader(archive))).finish();
+
+    std::cout << "Whole document: " << json.to_string() << '\n';
+    return 0;
+}
@@ -0,0 +1,30 @@
+// examples/parallel.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+
+int main() {
+    // A big buffer of JSON Lines, like a log file read into memory
+    std::string lines;
+    for (int i = 0; i < 100000; i++) lines += "{\"id\":" + std::to_string(i) + ",\"ok\":true}\n";
+
+    // Batches are parsed on every core, documents still come out in order on this thread
+    SJSON::ParallelParse json({}, {.ordered = true});
+    double sum = 0;
+    json.documents([&sum](const SJSON::JSValue& value) {
+        sum += value.object().at("id").number();
+    });
+    json.parse(lines);
+
+    std::cout << "Sum of every id: " << sum << '\n';
+
+    // One huge array is split into ranges of elements, generic listeners still get every element in order
+    std::string array = "[";
+    for (int i = 0; i < 100000; i++) array += (i ? ",{\"id\":" : "{\"id\":") + std::to_string(i) + "}";
+    array += "]";
+    SJSON::ParallelParse elements({.drop_generics = true});
+    size_t count = 0;
+    elements.listen("[]", [&count](const SJSON::JSValue&) { count++; });
+    auto value = elements.string(array);
+    std::cout << "Elements listened to: " << count << ", left in the array: " << value.array().size() << '\n';
+    return 0;
+}
@@ -0,0 +1,22 @@
+// examples/push.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <string_view>
+
+int main() {
+    // Nothing is pulled, whatever arrives (like reads from a socket in an event loop) gets fed and parsing returns right away
+    SJSON::Parse json(SJSON::ParseOptions {.drop_generics = true});
+    json.collect("test[]");
+
+    const std::string_view input(input_example);
+    for (size_t i = 0; i < input.size(); i += 16) {
+        json.feed(input.substr(i, 16)); // Pieces only have to live until feed returns
+        // Values come out as soon as they're complete
+        for (const auto& value : json.values())
+            std::cout << "Completed element: " << value.to_string() << '\n';
+    }
+    json.finish(); // Errors if the input ended early
+
+    std::cout << "Whatever wasn't dropped: " << json.to_string() << '\n';
+    return 0;
+}
@@ -0,0 +1,20 @@
+// examples/readahead.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <sstream>
+
+int main() {
+    // Stands in for a slow file or pipe, anything that's an std::istream (or a ByteReader) works
+    std::istringstream in(input_example);
+
+    // Reads happen on another thread into 4 reused buffers of 16 bytes while the parser works through the ones before
+    SJSON::ReadAhead input(in, 4, 16);
+    SJSON::Parse json;
+    json.listen("test[]", [](const SJSON::JSValue& value) {
+        std::cout << "Element: " << value.to_string() << '\n';
+    });
+    json.feed(input).finish();
+
+    std::cout << "Whole document: " << json.to_string() << '\n';
+    return 0;
+}
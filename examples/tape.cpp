@@ -0,0 +1,18 @@
+// examples/tape.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+
+int main() {
+    // The whole document in two buffers instead of a node per value
+    const auto doc = SJSON::Tape::string(input_example);
+
+    for (auto value : doc.root().object()["test"].array()) {
+        if (value.is_object())
+            std::cout << "Element: a = " << value.object()["a"].integer() << '\n';
+        else
+            std::cout << "Element: " << value.integer() << '\n';
+    }
+
+    std::cout << "Whole document: " << doc.to_string() << '\n';
+    return 0;
+}
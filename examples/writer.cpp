@@ -0,0 +1,20 @@
+// examples/writer.cpp
+#include "../src/sjson.hpp"
+#include "util.hpp"
+#include <unistd.h>
+
+int main() {
+    auto value = SJSON::Parse::string(input_example);
+
+    // Write straight to stdout in 4KiB blocks without ever building the whole string, indents are 4 spaces
+    SJSON::Writer::fd(STDOUT_FILENO, 4, 4096).write(value).raw("\n");
+
+    // Or hand the output to any sink, here compact and counting the bytes
+    size_t bytes = 0;
+    {
+        SJSON::Writer counter([&bytes](std::string_view chunk) { bytes += chunk.size(); });
+        counter.write(value);
+    } // Whatever's left is flushed when the writer goes out of scope
+    std::cout << "Compact JSON is " << bytes << " bytes\n";
+    return 0;
+}
@@ -0,0 +1,544 @@
+#pragma once
+#include "sjson.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SJSON {
+    class Bencher {
+    protected:
+        template <typename F>
+        inline static double time(F&& f) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        inline static void log(const std::string& name, double ms, const std::string& details = "") {
+            std::cout << "[BENCH] " << name << ": " << ms << " ms" << (details.empty() ? "" : " (" + details + ")") << '\n';
+        }
+        inline static void log_rate(const std::string& name, double ms, size_t bytes) {
+            log(name, ms, std::to_string(size_t(bytes / 1e6 / (ms / 1e3))) + " MB/s");
+        }
+        inline static void log_each(const std::string& name, double ms, size_t operations) {
+            log(name, ms, std::to_string(ms * 1e6 / operations) + " ns each");
+        }
+        inline static const char* policy_name(ObjectPolicy policy) {
+            switch (policy) {
+                case ObjectPolicy::Sorted: return "sorted";
+                case ObjectPolicy::Flat: return "flat";
+                case ObjectPolicy::Hashed: return "hashed";
+            }
+            return "unknown";
+        }
+
+        // Counts the bytes parsed values ask for
+        class CountingResource : public std::pmr::memory_resource {
+        public:
+            size_t allocated = 0;
+
+        protected:
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                allocated += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+        };
+
+        // Array of scalars, the shape of most telemetry
+        inline static std::string scalars(size_t count) {
+            std::string out = "[";
+            for (size_t i = 0; i < count; i++) {
+                out += i ? "," : "";
+                switch (i % 4) {
+                    case 0: out += std::to_string(i); break;
+                    case 1: out += std::to_string(i) + ".5"; break;
+                    case 2: out += i % 8 == 2 ? "true" : "null"; break;
+                    case 3: out += "\"id_" + std::to_string(i) + "\""; break;
+                }
+            }
+            return out + "]";
+        }
+        // Array of long strings, escapes and non-ASCII text sprinkled in
+        inline static std::string texts(size_t count) {
+            std::string out = "[";
+            for (size_t i = 0; i < count; i++) {
+                out += i ? ",\"" : "\"";
+                out += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ";
+                out += i % 4 ? "ut labore et dolore magna aliqua\\n" : "ут лабore эт долоре магна аликва ";
+                out += std::to_string(i) + "\"";
+            }
+            return out + "]";
+        }
+        // Array of records that all share the same few keys, the shape of most telemetry
+        inline static std::string records(size_t count, size_t keys) {
+            std::string out = "[";
+            for (size_t i = 0; i < count; i++) {
+                out += i ? ",{" : "{";
+                for (size_t k = 0; k < keys; k++)
+                    out += (k ? ",\"field_" : "\"field_") + std::to_string(k) + "\":" + std::to_string(i * keys + k);
+                out += "}";
+            }
+            return out + "]";
+        }
+        // Same records as JSON Lines
+        inline static std::string lines(size_t count, size_t keys) {
+            std::string out;
+            for (size_t i = 0; i < count; i++) {
+                out += "{";
+                for (size_t k = 0; k < keys; k++)
+                    out += (k ? ",\"field_" : "\"field_") + std::to_string(k) + "\":" + std::to_string(i * keys + k);
+                out += "}\n";
+            }
+            return out;
+        }
+        // A single object with lots of members
+        inline static std::string wide_object(size_t keys) {
+            std::string out = "{";
+            for (size_t k = 0; k < keys; k++)
+                out += (k ? ",\"member_" : "\"member_") + std::to_string(k) + "\":" + std::to_string(k);
+            return out + "}";
+        }
+
+    public:
+        inline Bencher() { run(); }
+        ~Bencher() = default;
+
+        inline void section(const char* name) const {
+            std::cout << "[SECTION] Now benchmarking " << name << '\n';
+        }
+
+        inline void values() {
+            section("values");
+            constexpr size_t count = 1000000;
+            const auto src = scalars(count);
+            std::cout << "[BENCH] sizeof(JSValue): " << sizeof(JSValue) << " bytes\n";
+            CountingResource counter;
+            JSValue value;
+            log_rate("parse array of scalars", time([&]() { value = Parse::string(src, {.resource = &counter}); }), src.size());
+            std::cout << "[BENCH] array of scalars allocated: " << (counter.allocated >> 20) << " MiB (" << counter.allocated / count << " bytes per value)\n";
+        }
+
+        inline void objects() {
+            section("object policies");
+            constexpr size_t record_count = 200000;
+            constexpr size_t record_keys = 6;
+            constexpr size_t wide_keys = 10000;
+            const auto small = records(record_count, record_keys);
+            const auto wide = wide_object(wide_keys);
+            std::vector<std::string> small_keys, wide_names;
+            for (size_t k = 0; k < record_keys; k++) small_keys.push_back("field_" + std::to_string(k));
+            for (size_t k = 0; k < wide_keys; k++) wide_names.push_back("member_" + std::to_string(k));
+            for (const auto policy : {ObjectPolicy::Sorted, ObjectPolicy::Flat, ObjectPolicy::Hashed}) {
+                const std::string name = policy_name(policy);
+                const ParseOptions options {.objects = policy};
+                JSValue value;
+                log_rate(name + " build small objects", time([&]() { value = Parse::string(small, options); }), small.size());
+                const auto small_lookup = time([&]() {
+                    for (const auto& record : value.array())
+                        for (const auto& key : small_keys) record.object().contains(key);
+                });
+                log_each(name + " lookup small objects", small_lookup, record_count * record_keys);
+                value = JSValue();
+                log_rate(name + " build large object", time([&]() { value = Parse::string(wide, options); }), wide.size());
+                const auto wide_lookup = time([&]() {
+                    for (const auto& key : wide_names) value.object().contains(key);
+                });
+                log_each(name + " lookup large object", wide_lookup, wide_keys);
+            }
+        }
+
+        inline void strings() {
+            section("strings");
+            const auto src = texts(100000);
+            JSValue value;
+            for (const bool validate : {false, true}) {
+                const ParseOptions options {.validate_utf8 = validate};
+                const auto ms = time([&]() { value = Parse::string(src, options); });
+                log_rate(validate ? "parse validating utf-8" : "parse", ms, src.size());
+            }
+        }
+
+        inline void keys() {
+            section("key interning");
+            constexpr size_t record_count = 200000;
+            const auto src = records(record_count, 6);
+            for (const bool intern : {false, true}) {
+                const std::string name = intern ? "interned" : "plain";
+                CountingResource counter;
+                JSValue value;
+                const ParseOptions options {.resource = &counter, .objects = ObjectPolicy::Flat, .intern_keys = intern};
+                log_rate(name + " keys parse records", time([&]() { value = Parse::string(src, options); }), src.size());
+                std::cout << "[BENCH] " << name << " keys allocated: " << (counter.allocated >> 20) << " MiB (" << counter.allocated / record_count << " bytes per record)\n";
+            }
+        }
+
+        inline void writer() {
+            section("writer");
+            const auto src = records(200000, 6);
+            const auto value = Parse::string(src);
+            size_t bytes = 0;
+            auto ms = time([&]() { bytes = value.to_string().size(); });
+            log_rate("compact to_string", ms, bytes);
+            ms = time([&]() { bytes = value.to_string(4).size(); });
+            log_rate("pretty to_string", ms, bytes);
+            std::string out;
+            Writer reused(out);
+            reused.write(value); // Warm up the buffer
+            ms = time([&]() {
+                out.clear();
+                reused.write(value);
+            });
+            log_rate("compact into a reused buffer", ms, out.size());
+            bytes = 0;
+            ms = time([&]() {
+                Writer sink([&bytes](std::string_view chunk) { bytes += chunk.size(); });
+                sink.write(value);
+            });
+            log_rate("compact into a sink", ms, bytes);
+            const auto strings = Parse::string(texts(100000));
+            ms = time([&]() { bytes = strings.to_string().size(); });
+            log_rate("escape strings", ms, bytes);
+            ms = time([&]() {
+                out.clear();
+                Writer(out).ascii().write(strings);
+            });
+            log_rate("escape strings as ascii", ms, out.size());
+        }
+
+        inline void listeners() {
+            section("listeners");
+            const auto src = records(200000, 6);
+            const auto parse = [&src](std::initializer_list<const char*> labels, bool drop) {
+                size_t calls = 0;
+                Parse json([&src, done = false]() mutable -> std::string {
+                    if (done) return "";
+                    done = true;
+                    return src;
+                },
+                    drop);
+                for (const auto label : labels) json.listen(label, [&calls](const JSValue&) { calls++; });
+                json.all();
+                return calls;
+            };
+            size_t calls = 0;
+            log_rate("no listeners", time([&]() { calls = parse({}, false); }), src.size());
+            log_rate("listener that never matches", time([&]() { calls = parse({"missing[].field_0"}, false); }), src.size());
+            log_rate("exact listener", time([&]() { calls = parse({"[100000].field_0"}, false); }), src.size());
+            log_rate("generic listener", time([&]() { calls = parse({"[].field_0"}, false); }), src.size());
+            log_rate("dropping generic listener", time([&]() { calls = parse({"[]"}, true); }), src.size());
+            std::cout << "[BENCH] dropping generic listener calls: " << calls << '\n';
+        }
+
+        inline void projection() {
+            section("projection");
+            const auto src = "{\"meta\":{\"count\":200000},\"texts\":" + texts(20000) + ",\"records\":" + records(200000, 6) + "}";
+            for (const bool project : {false, true}) {
+                const std::string name = project ? "projected" : "full";
+                CountingResource counter;
+                JSValue count;
+                Parse json([&src, done = false]() mutable -> std::string {
+                    if (done) return "";
+                    done = true;
+                    return src;
+                },
+                    {.project = project, .resource = &counter});
+                json.listen("meta.count", [&count](const JSValue& value) { count = value; });
+                log_rate(name + " parse for one field", time([&]() { json.all(); }), src.size());
+                std::cout << "[BENCH] " << name << " allocated: " << counter.allocated << " bytes\n";
+            }
+        }
+
+        inline void events() {
+            section("events");
+            const auto src = records(200000, 6);
+            // Counts values the way a handler feeding its own structures would touch them
+            struct Counter : Handler {
+                size_t values = 0;
+                void key(std::string_view) override { values++; }
+                void number(std::string_view) override { values++; }
+            } counter;
+            JSValue value;
+            log_rate("parse records", time([&]() { value = Parse::string(src); }), src.size());
+            log_rate("events for records", time([&]() { Events::string(src, counter); }), src.size());
+            std::cout << "[BENCH] events counted: " << counter.values << '\n';
+        }
+
+        inline void cursor() {
+            section("cursor");
+            const auto src = records(200000, 6);
+            int64_t sum = 0;
+            log_rate("parse and sum two fields", time([&]() {
+                sum = 0;
+                const auto value = Parse::string(src);
+                for (const auto& record : value.array())
+                    sum += record.object().at("field_1").integer() + record.object().at("field_4").integer();
+            }),
+                src.size());
+            const auto expected = sum;
+            log_rate("cursor sum two fields", time([&]() {
+                sum = 0;
+                Cursor doc(src);
+                for (auto record : doc.root().get_array()) {
+                    auto object = record.get_object();
+                    sum += object["field_1"].get_int64() + object["field_4"].get_int64();
+                }
+            }),
+                src.size());
+            std::cout << "[BENCH] cursor sum matches: " << (sum == expected ? "yes" : "no") << '\n';
+        }
+
+        inline void tape() {
+            section("tape");
+            const auto src = records(200000, 6);
+            log_rate("parse into values", time([&]() { Parse::string(src); }), src.size());
+            log_rate("parse into a tape", time([&]() { Tape::string(src); }), src.size());
+            const auto value = Parse::string(src);
+            const auto doc = Tape::string(src);
+            int64_t sum = 0;
+            log_rate("walk values", time([&]() {
+                sum = 0;
+                for (const auto& record : value.array())
+                    for (const auto& [key, field] : record.object()) sum += field.integer();
+            }),
+                src.size());
+            const auto expected = sum;
+            log_rate("walk the tape", time([&]() {
+                sum = 0;
+                for (auto record : doc.root().array())
+                    for (auto [key, field] : record.object()) sum += field.integer();
+            }),
+                src.size());
+            std::cout << "[BENCH] tape sum matches: " << (sum == expected ? "yes" : "no") << '\n';
+            std::cout << "[BENCH] tape is " << doc.size() * sizeof(uint64_t) + doc.string_buffer().size() << " bytes for " << src.size() << " bytes of JSON\n";
+        }
+
+        inline void documents() {
+            section("documents");
+            const auto src = lines(200000, 6);
+            size_t count = 0;
+            log_rate("parse each line", time([&]() {
+                count = 0;
+                for (size_t i = 0, end; (end = src.find('\n', i)) != std::string::npos; i = end + 1) {
+                    Parse::string(src.substr(i, end - i));
+                    count++;
+                }
+            }),
+                src.size());
+            log_rate("multi-document parse", time([&]() {
+                count = 0;
+                Parse json(src, ParseOptions {.multi_document = true});
+            }),
+                src.size());
+            Parse json(ParseOptions {.multi_document = true});
+            json.documents([&count](const JSValue&) { count++; });
+            log_rate("multi-document parse with a callback", time([&]() {
+                count = 0;
+                json.feed(src).finish();
+            }),
+                src.size());
+            std::cout << "[BENCH] documents counted: " << count << '\n';
+        }
+
+        inline void parallel() {
+            section("parallel documents");
+            const auto src = lines(400000, 6);
+            size_t count = 0;
+            log_rate("single thread multi-document parse", time([&]() {
+                Parse json(ParseOptions {.multi_document = true});
+                json.documents([&count](const JSValue&) { count++; });
+                json.feed(src).finish();
+            }),
+                src.size());
+            const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+            std::vector<size_t> counts {1};
+            if (cores > 1) counts.push_back(cores);
+            for (const size_t threads : counts) {
+                for (const bool ordered : {true, false}) {
+                    ParallelParse json({}, {.threads = threads, .ordered = ordered});
+                    json.documents([&count](const JSValue&) { count++; });
+                    const auto name = std::to_string(threads) + (threads == 1 ? " thread " : " threads ") + (ordered ? "ordered" : "unordered");
+                    log_rate(name, time([&]() { json.parse(src); }), src.size());
+                }
+            }
+            std::cout << "[BENCH] documents counted: " << count << '\n';
+
+            const auto array = records(400000, 6);
+            JSValue value;
+            log_rate("single thread array parse", time([&]() { value = Parse::string(array); }), array.size());
+            for (const size_t threads : counts) {
+                ParallelParse json({}, {.threads = threads});
+                const auto name = std::to_string(threads) + (threads == 1 ? " thread array" : " threads array");
+                log_rate(name, time([&]() { value = json.string(array); }), array.size());
+            }
+            // Dropping every element keeps memory to a few batches
+            ParallelParse json({.drop_generics = true}, {.threads = cores});
+            json.listen("[]", [&count](const JSValue&) { count++; });
+            log_rate("array with dropped elements", time([&]() { value = json.string(array); }), array.size());
+        }
+
+        inline void files() {
+            section("files");
+            const auto path = std::filesystem::temp_directory_path() / "sjson_bench.json";
+            const auto src = records(400000, 6);
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << src;
+            }
+            JSValue value;
+            log_rate("read then parse", time([&]() {
+                std::ifstream in(path, std::ios::binary);
+                std::ostringstream out;
+                out << in.rdbuf();
+                value = Parse::string(std::move(out).str());
+            }),
+                src.size());
+            log_rate("mapped parse", time([&]() { value = Parse::file(path.string()); }), src.size());
+            size_t count = 0;
+            // Nothing's kept so only the window is ever resident
+            log_rate("mapped parse with dropped elements", time([&]() {
+                MappedFile file(path.string());
+                Parse json(ParseOptions {.drop_generics = true});
+                json.listen("[]", [&count](const JSValue&) { count++; });
+                json.feed(file).finish();
+            }),
+                src.size());
+
+            // Pulling blocks on every read, reading ahead overlaps them with parsing
+            log_rate("stream of 1 MiB reads", time([&]() {
+                std::ifstream in(path, std::ios::binary);
+                value = Parse::stream([&in, buffer = std::string(1 << 20, '\0')]() mutable -> std::string {
+                    in.read(buffer.data(), std::streamsize(buffer.size()));
+                    return buffer.substr(0, size_t(in.gcount()));
+                });
+            }),
+                src.size());
+            log_rate("read-ahead of 1 MiB buffers", time([&]() {
+                std::ifstream in(path, std::ios::binary);
+                ReadAhead input(in);
+                Parse json;
+                json.feed(input).finish();
+                value = std::move(json.value);
+            }),
+                src.size());
+            std::filesystem::remove(path);
+        }
+
+        inline void cache() {
+            section("tape cache");
+            const auto path = std::filesystem::temp_directory_path() / "sjson_bench.json";
+            const auto cache_path = std::filesystem::temp_directory_path() / "sjson_bench.tape";
+            const auto src = records(400000, 6);
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << src;
+            }
+            std::filesystem::remove(cache_path);
+            log_rate("mapped parse", time([&]() { Parse::file(path.string()); }), src.size());
+            log_rate("build the cache", time([&]() { CachedTape::open(path.string(), cache_path.string()); }), src.size());
+            log_rate("open the cache", time([&]() { CachedTape::open(path.string(), cache_path.string()); }), src.size());
+            log_rate("open the cache trusting timestamps", time([&]() { CachedTape::open(path.string(), cache_path.string(), {}, false); }), src.size());
+            int64_t sum = 0;
+            log_rate("open the cache unchecked and sum a field", time([&]() {
+                sum = 0;
+                CachedTape doc(cache_path.string());
+                for (auto record : doc.root().array()) sum += record.object()["field_1"].integer();
+            }),
+                src.size());
+            std::filesystem::remove(path);
+            std::filesystem::remove(cache_path);
+        }
+
+        inline void compressed() {
+            section("gzip");
+            const auto src = records(400000, 6);
+            const auto archive = gzip(src);
+            const auto reader = [&archive]() {
+                return [&archive, i = size_t(0)](char* data, size_t size) mutable -> size_t {
+                    size = std::min(size, archive.size() - i);
+                    std::copy_n(archive.data() + i, size, data);
+                    i += size;
+                    return size;
+                };
+            };
+            std::cout << "[BENCH] " << src.size() << " bytes compressed to " << archive.size() << '\n';
+            JSValue value;
+            log_rate("inflate then parse", time([&]() {
+                GzipReader inflater(reader());
+                std::string inflated;
+                char buffer[1 << 16];
+                for (size_t size; (size = inflater(buffer, sizeof(buffer)));) inflated.append(buffer, size);
+                value = Parse::string(std::move(inflated));
+            }),
+                src.size());
+            log_rate("inflate while parsing", time([&]() {
+                Parse json;
+                json.feed(GzipReader(reader())).finish();
+                value = std::move(json.value);
+            }),
+                src.size());
+            // Inflating is usually the slower half, so this only helps with a spare core
+            log_rate("inflate on a read-ahead thread", time([&]() {
+                ReadAhead input {GzipReader(reader())};
+                Parse json;
+                json.feed(input).finish();
+                value = std::move(json.value);
+            }),
+                src.size());
+        }
+
+        inline void cbor() {
+            section("cbor");
+            const auto src = records(400000, 6);
+            JSValue value = Parse::string(src);
+            std::string bytes;
+            log_rate("encode", time([&]() { bytes = CBORWriter::to_string(value); }), src.size());
+            std::cout << "[BENCH] " << src.size() << " bytes of JSON are " << bytes.size() << " bytes of CBOR\n";
+            log_rate("parse json", time([&]() { value = Parse::string(src); }), src.size());
+            log_rate("decode cbor", time([&]() { value = Parse::cbor(bytes); }), src.size());
+            size_t count = 0;
+            // Listeners work the same either way
+            for (const auto format : {Format::JSON, Format::CBOR}) {
+                Parse json(ParseOptions {.drop_generics = true, .format = format});
+                json.listen("[]", [&count](const JSValue&) { count++; });
+                const auto& input = format == Format::JSON ? src : bytes;
+                log_rate(format == Format::JSON ? "parse json with dropped elements" : "decode cbor with dropped elements", time([&]() {
+                    json.feed(input).finish();
+                }),
+                    src.size());
+            }
+        }
+
+        inline void run() {
+            values();
+            strings();
+            keys();
+            writer();
+            listeners();
+            projection();
+            events();
+            cursor();
+            tape();
+            documents();
+            parallel();
+            files();
+            cache();
+            compressed();
+            cbor();
+            objects();
+        }
+    };
+} // namespace SJSON
@@ -0,0 +1,153 @@
+#include "cache.hpp"
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+
+namespace SJSON {
+    static constexpr char tape_magic[8] = {'S', 'J', 'S', 'O', 'N', 'T', 'A', 'P'};
+    static constexpr uint32_t byte_order = 0x01020304;
+    static constexpr uint64_t raw_numbers_flag = 1;
+    static constexpr uint64_t validated_flag = 2;
+
+    static uint64_t flags_of(const ParseOptions& options) noexcept {
+        return (options.raw_numbers ? raw_numbers_flag : 0) | (options.validate_utf8 ? validated_flag : 0);
+    }
+    // A validated tape is just as good for a parse that doesn't validate, raw numbers change the entries though
+    static bool compatible(uint64_t flags, const ParseOptions& options) noexcept {
+        const auto wanted = flags_of(options);
+        return (flags & raw_numbers_flag) == (wanted & raw_numbers_flag) && (flags & validated_flag) >= (wanted & validated_flag);
+    }
+    static int64_t mtime_of(const std::string& path) {
+        std::error_code ec;
+        const auto time = std::filesystem::last_write_time(path, ec);
+        return ec ? 0 : int64_t(time.time_since_epoch().count());
+    }
+
+    CachedTape::CachedTape(const std::string& path):
+        file(path) {
+        const auto data = file.view();
+        if (data.size() < sizeof(TapeFileHeader) || std::memcmp(data.data(), tape_magic, sizeof(tape_magic)) != 0)
+            throw std::runtime_error("CachedTape: " + path + " isn't a tape file");
+        const auto& h = header();
+        if (h.version != version || h.byte_order != byte_order)
+            throw std::runtime_error("CachedTape: " + path + " was written by another version or byte order");
+        const auto room = data.size() - sizeof(TapeFileHeader);
+        if (!h.entries || h.entries > room / sizeof(uint64_t) || h.string_bytes != room - h.entries * sizeof(uint64_t))
+            throw std::runtime_error("CachedTape: " + path + " is truncated");
+    }
+    const TapeFileHeader& CachedTape::header() const noexcept {
+        return *reinterpret_cast<const TapeFileHeader*>(file.view().data());
+    }
+    void CachedTape::write(const std::string& path, const Tape& tape, const TapeFileHeader& header) {
+        if (tape.empty()) throw std::logic_error("CachedTape: an empty tape can't be saved");
+        // Random so processes rebuilding the same cache at once don't write into each other's file
+        const auto temp = path + ".tmp" + std::to_string(std::random_device()());
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::system_error(errno, std::generic_category(), "CachedTape: can't write " + temp);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(tape.tape().data()), std::streamsize(tape.size() * sizeof(uint64_t)));
+            out.write(tape.string_buffer().data(), std::streamsize(tape.string_buffer().size()));
+            out.flush();
+            if (!out) {
+                const int err = errno;
+                std::filesystem::remove(temp);
+                throw std::system_error(err, std::generic_category(), "CachedTape: can't write " + temp);
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+        if (ec) {
+            std::filesystem::remove(temp);
+            throw std::system_error(ec, "CachedTape: can't replace " + path);
+        }
+    }
+
+    // Everything but the hash and the tape's own sizes
+    static TapeFileHeader header_of(const MappedFile& source, const std::string& source_path, const ParseOptions& options) {
+        TapeFileHeader header {};
+        std::memcpy(header.magic, tape_magic, sizeof(tape_magic));
+        header.version = CachedTape::version;
+        header.byte_order = byte_order;
+        header.flags = flags_of(options);
+        header.source_size = source.size();
+        header.source_mtime = mtime_of(source_path);
+        return header;
+    }
+
+    CachedTape CachedTape::open(const std::string& source_path, const std::string& cache_path, ParseOptions options, bool check_hash) {
+        MappedFile source(source_path);
+        auto wanted = header_of(source, source_path, options);
+        if (check_hash) wanted.source_hash = hash(source.view());
+        try {
+            CachedTape cached(cache_path);
+            const auto& h = cached.header();
+            const bool same = check_hash ? h.source_hash == wanted.source_hash : h.source_mtime == wanted.source_mtime;
+            if (same && h.source_size == wanted.source_size && compatible(h.flags, options)) return cached;
+        } catch (const std::runtime_error&) {
+            // Missing, unreadable or from another version, all just mean it's rebuilt
+        }
+        if (!check_hash) wanted.source_hash = hash(source.view()); // Saved caches always carry the hash
+        const auto tape = Tape::file(source, options);
+        wanted.entries = tape.size();
+        wanted.string_bytes = tape.string_buffer().size();
+        write(cache_path, tape, wanted);
+        CachedTape cached(cache_path);
+        cached.was_rebuilt = true;
+        return cached;
+    }
+    void CachedTape::save(const std::string& path, const Tape& tape, const std::string& source_path, ParseOptions options) {
+        const MappedFile source(source_path);
+        auto header = header_of(source, source_path, options);
+        header.source_hash = hash(source.view());
+        header.entries = tape.size();
+        header.string_bytes = tape.string_buffer().size();
+        write(path, tape, header);
+    }
+    // Four independent lanes of multiply and rotate so a few gigabytes a second are hashed, then mixed down
+    uint64_t CachedTape::hash(std::string_view src) {
+        constexpr uint64_t prime_1 = 0x9e3779b185ebca87;
+        constexpr uint64_t prime_2 = 0xc2b2ae3d27d4eb4f;
+        const auto word = [&src](size_t i) {
+            uint64_t v;
+            std::memcpy(&v, src.data() + i, sizeof(v));
+            return v;
+        };
+        uint64_t lanes[4] = {prime_1 + prime_2, prime_2, 0, 0 - prime_1};
+        size_t i = 0;
+        for (; i + 32 <= src.size(); i += 32)
+            for (size_t lane = 0; lane < 4; lane++) lanes[lane] = std::rotl(lanes[lane] + word(i + lane * 8) * prime_2, 31) * prime_1;
+        uint64_t h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18) + src.size();
+        for (; i + 8 <= src.size(); i += 8) h = std::rotl(h ^ (word(i) * prime_2), 27) * prime_1;
+        for (; i < src.size(); i++) h = std::rotl(h ^ (uint8_t(src[i]) * prime_1), 11) * prime_2;
+        h ^= h >> 33;
+        h *= prime_2;
+        h ^= h >> 29;
+        return h;
+    }
+
+    TapeRef CachedTape::root() const {
+        const auto data = file.view().data() + sizeof(TapeFileHeader);
+        return TapeRef(reinterpret_cast<const uint64_t*>(data), data + header().entries * sizeof(uint64_t));
+    }
+    size_t CachedTape::size() const noexcept {
+        return size_t(header().entries);
+    }
+    uint64_t CachedTape::source_size() const noexcept {
+        return header().source_size;
+    }
+    uint64_t CachedTape::source_hash() const noexcept {
+        return header().source_hash;
+    }
+    bool CachedTape::rebuilt() const noexcept {
+        return was_rebuilt;
+    }
+    std::string CachedTape::to_string() const {
+        return root().to_string();
+    }
+} // namespace SJSON
@@ -0,0 +1,65 @@
+#pragma once
+#include "file.hpp"
+#include "options.hpp"
+#include "tape.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace SJSON {
+    // In front of a saved tape, followed by its entries and then its strings, all in the writer's byte order
+    struct TapeFileHeader {
+        char magic[8];          // "SJSONTAP"
+        uint32_t version;
+        uint32_t byte_order;    // 0x01020304 as the writer stored it
+        uint64_t flags;         // ParseOptions that change what's on the tape
+        uint64_t source_size;
+        uint64_t source_hash;
+        int64_t source_mtime;   // Only compared when the hash isn't
+        uint64_t entries;
+        uint64_t string_bytes;
+    };
+    static_assert(sizeof(TapeFileHeader) == 64);
+
+    /*
+        A tape saved to disk and mapped back read-only, nothing is parsed or deserialized to read it
+        Offsets on a tape are relative to its own buffers so the file works wherever it's mapped
+        The header is checked but the tape itself isn't, so cache files should only come from save() or open()
+    */
+    class CachedTape {
+    protected:
+        MappedFile file;
+        bool was_rebuilt = false;
+
+        const TapeFileHeader& header() const noexcept;
+        static void write(const std::string& path, const Tape& tape, const TapeFileHeader& header);
+
+    public:
+        inline static constexpr uint32_t version = 1;
+
+        explicit CachedTape(const std::string& path); // Throws std::runtime_error if it isn't a tape file this build can read
+        CachedTape(const CachedTape&) = delete;
+        CachedTape& operator=(const CachedTape&) = delete;
+        CachedTape(CachedTape&&) noexcept = default;
+        CachedTape& operator=(CachedTape&&) noexcept = default;
+        ~CachedTape() = default;
+
+        /*
+            Maps cache_path if it was made from source_path as it is now with the same options, otherwise parses the source
+            and replaces the cache first (written next to it and renamed, so readers never see half a file)
+            The source is hashed unless check_hash is false, then its size and modification time have to match instead
+        */
+        static CachedTape open(const std::string& source_path, const std::string& cache_path, ParseOptions options = {}, bool check_hash = true);
+        // For a tape parsed from source_path as it is now, what open() writes so it maps the file back whether it checks the hash or not
+        static void save(const std::string& path, const Tape& tape, const std::string& source_path, ParseOptions options = {});
+        static uint64_t hash(std::string_view src); // Fast and not cryptographic, only for noticing changes
+
+        TapeRef root() const;
+        size_t size() const noexcept; // Entries
+        uint64_t source_size() const noexcept;
+        uint64_t source_hash() const noexcept;
+        bool rebuilt() const noexcept; // open() had to parse the source
+        std::string to_string() const;
+    };
+} // namespace SJSON
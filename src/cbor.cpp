@@ -0,0 +1,278 @@
+#include "cbor.hpp"
+#include "sjson.hpp"
+#include "syntax.hpp"
+#include "util.hpp"
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace SJSON {
+    // Big endian, whatever the host is
+    static void put_be(std::string& out, uint64_t v, size_t bytes) {
+        for (size_t i = bytes; i-- > 0;) out.push_back(char(uint8_t(v >> (i * 8))));
+    }
+    static uint64_t get_be(std::string_view src, size_t bytes) {
+        uint64_t v = 0;
+        for (size_t i = 0; i < bytes; i++) v = (v << 8) | uint8_t(src[i]);
+        return v;
+    }
+    static double half_to_double(uint16_t half) {
+        const int exponent = (half >> 10) & 0x1f;
+        const double mantissa = half & 0x3ff;
+        double v;
+        if (exponent == 0)
+            v = std::ldexp(mantissa, -24);
+        else if (exponent == 31)
+            v = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+        else
+            v = std::ldexp(mantissa + 1024, exponent - 25);
+        return half & 0x8000 ? -v : v;
+    }
+
+    void CBORWriter::head(std::string& out, uint8_t major, uint64_t arg) {
+        major <<= 5;
+        if (arg < 24) {
+            out.push_back(char(major | arg));
+        } else if (arg <= 0xff) {
+            out.push_back(char(major | 24));
+            put_be(out, arg, 1);
+        } else if (arg <= 0xffff) {
+            out.push_back(char(major | 25));
+            put_be(out, arg, 2);
+        } else if (arg <= 0xffffffff) {
+            out.push_back(char(major | 26));
+            put_be(out, arg, 4);
+        } else {
+            out.push_back(char(major | 27));
+            put_be(out, arg, 8);
+        }
+    }
+    void CBORWriter::scalar(std::string& out, const JSValue& value) {
+        switch (value.kind) {
+            case JSValue::Kind::Null: out.push_back(char(0xf6)); break;
+            case JSValue::Kind::Boolean: out.push_back(char(value.get<JSBoolean>() ? 0xf5 : 0xf4)); break;
+            case JSValue::Kind::Integer: {
+                const auto v = value.get<JSInteger>();
+                if (v >= 0)
+                    head(out, 0, uint64_t(v));
+                else
+                    head(out, 1, uint64_t(-(v + 1))); // -1 - n, and the +1 keeps INT64_MIN from overflowing
+                break;
+            }
+            case JSValue::Kind::Unsigned: head(out, 0, value.get<JSUnsigned>()); break;
+            case JSValue::Kind::Number:
+            case JSValue::Kind::RawNumber: {
+                // Floats take half the space when they're exact
+                const double v = value.number();
+                if (const float f = float(v); double(f) == v || std::isnan(v)) {
+                    out.push_back(char(0xfa));
+                    put_be(out, std::bit_cast<uint32_t>(f), 4);
+                } else {
+                    out.push_back(char(0xfb));
+                    put_be(out, std::bit_cast<uint64_t>(v), 8);
+                }
+                break;
+            }
+            case JSValue::Kind::SmallString:
+            case JSValue::Kind::String: {
+                const auto text = value.string_view();
+                head(out, 3, text.size());
+                out += text;
+                break;
+            }
+            default: break;
+        }
+    }
+    void CBORWriter::write(std::string& out, const JSValue& value) {
+        // A container that's still being written
+        struct Frame {
+            const JSValue* container;
+            JSObject::const_iterator member;
+            size_t element = 0;
+        };
+        std::vector<Frame> stack;
+        const JSValue* next = &value;
+        while (true) {
+            if (next) {
+                if (next->is_array()) {
+                    head(out, 4, next->array().size());
+                    stack.push_back({next, {}});
+                } else if (next->is_object()) {
+                    head(out, 5, next->object().size());
+                    stack.push_back({next, next->object().begin()});
+                } else {
+                    scalar(out, *next);
+                }
+                next = nullptr;
+            }
+            if (stack.empty()) return;
+            auto& frame = stack.back();
+            if (frame.container->is_array()) {
+                const auto& array = frame.container->array();
+                if (frame.element == array.size()) {
+                    stack.pop_back();
+                    continue;
+                }
+                next = &array[frame.element++];
+            } else {
+                if (frame.member == frame.container->object().end()) {
+                    stack.pop_back();
+                    continue;
+                }
+                const auto key = frame.member->first.view();
+                head(out, 3, key.size());
+                out += key;
+                next = &frame.member->second;
+                ++frame.member;
+            }
+        }
+    }
+    std::string CBORWriter::to_string(const JSValue& value) {
+        std::string out;
+        write(out, value);
+        return out;
+    }
+
+    // Whatever the chunk doesn't finish waits in pending, only the bytes the cut off item still needs are copied
+    void CBORDecoder::decode(Parse& parse, std::string_view src, bool eof) {
+        if (eof) {
+            if (!pending.empty() || (!parse.is_finished() && !(parse.options.multi_document && parse.is_fresh())))
+                throw sjson_parse_error::unexpected_eof();
+            return;
+        }
+        while (!pending.empty()) {
+            const auto take = std::min(needed - pending.size(), src.size());
+            pending.append(src.data(), take);
+            src.remove_prefix(take);
+            if (pending.size() < needed) return;
+            if (item(parse, pending)) pending.clear(); // Otherwise only the head was there and needed grew
+        }
+        while (!src.empty()) {
+            const auto used = item(parse, src);
+            if (!used) {
+                pending.assign(src);
+                return;
+            }
+            src.remove_prefix(used);
+        }
+    }
+    size_t CBORDecoder::item(Parse& parse, std::string_view src) {
+        const auto initial = uint8_t(src[0]);
+        const int major = initial >> 5;
+        const int info = initial & 0x1f;
+        size_t size = 1;
+        uint64_t arg = info;
+        if (info >= 24 && info <= 27) {
+            size += size_t(1) << (info - 24);
+            if (src.size() < size) {
+                needed = size;
+                return 0;
+            }
+            arg = get_be(src.substr(1), size - 1);
+        } else if (info >= 28 && info <= 30) {
+            throw sjson_parse_error::invalid_cbor("reserved additional information");
+        }
+        const bool indefinite = info == 31;
+        if (indefinite && major != 4 && major != 5 && major != 7)
+            throw sjson_parse_error::invalid_cbor(major == 2 || major == 3 ? "chunked strings aren't supported" : "indefinite length on a scalar");
+        if (major == 6) return size; // Tags don't change what the value is
+        if (major == 7 && indefinite) {
+            if (!frames.has_top() || !frames.top().indefinite) throw sjson_parse_error::invalid_cbor("break outside of an indefinite container");
+            end(parse);
+            return ended(parse, size);
+        }
+        std::string_view payload;
+        if (major == 2 || major == 3) {
+            if (arg > std::numeric_limits<size_t>::max() - size) throw sjson_parse_error::invalid_cbor("string too long");
+            if (src.size() - size < arg) {
+                needed = size + size_t(arg);
+                return 0;
+            }
+            payload = src.substr(size, size_t(arg));
+            size += size_t(arg);
+        }
+
+        // The item is all there
+        parse.open_document();
+        bool is_key = false;
+        bool inside_skipped = false;
+        if (frames.has_top()) {
+            auto& frame = frames.top();
+            if (!frame.indefinite) frame.remaining--;
+            if (frame.map) {
+                is_key = frame.key_next;
+                frame.key_next = !frame.key_next;
+            }
+            inside_skipped = frame.skipped;
+        }
+        if (is_key) {
+            if (major != 3) throw sjson_parse_error::invalid_cbor("map keys have to be text strings");
+            if (parse.options.validate_utf8 && !is_valid_utf8(payload)) throw sjson_parse_error::invalid_utf8(jsstring_escape(payload));
+            if (!inside_skipped) parse.begin_member(payload);
+            return size;
+        }
+        if (major == 2) throw sjson_parse_error::invalid_cbor("byte strings have no JSON equivalent");
+        if (major == 4 || major == 5) {
+            if (!indefinite && major == 5 && arg > std::numeric_limits<uint64_t>::max() / 2) throw sjson_parse_error::invalid_cbor("map too long");
+            start(parse, major == 4, major == 5 ? arg * 2 : arg, indefinite);
+        } else if (!inside_skipped) {
+            parse.put_scalar([&] { return scalar(parse.options, major, info, arg, payload); });
+        }
+        return ended(parse, size);
+    }
+    // Definite containers end on their last item, which can end the one around them too
+    size_t CBORDecoder::ended(Parse& parse, size_t size) {
+        while (frames.has_top() && !frames.top().indefinite && frames.top().remaining == 0) end(parse);
+        parse.close_document();
+        return size;
+    }
+    JSValue CBORDecoder::scalar(const ParseOptions& options, int major, int info, uint64_t arg, std::string_view payload) {
+        switch (major) {
+            case 0: {
+                if (arg <= uint64_t(std::numeric_limits<JSInteger>::max())) return JSValue(JSInteger(arg));
+                return JSValue(JSUnsigned(arg));
+            }
+            case 1: {
+                if (arg <= uint64_t(std::numeric_limits<JSInteger>::max())) return JSValue(JSInteger(-1 - JSInteger(arg)));
+                if (!options.raw_numbers) return JSValue(-1.0 - double(arg));
+                // -1 - arg has one more digit than 64 bits hold at the very end
+                auto text = arg == std::numeric_limits<uint64_t>::max() ? std::string("18446744073709551616") : std::to_string(arg + 1);
+                return JSValue(JSRawNumber {JSString("-" + text, options.memory())});
+            }
+            case 3: {
+                if (options.validate_utf8 && !is_valid_utf8(payload)) throw sjson_parse_error::invalid_utf8(jsstring_escape(payload));
+                return JSValue(payload, options.memory());
+            }
+        }
+        switch (info) {
+            case 20: return JSValue(false);
+            case 21: return JSValue(true);
+            case 22:
+            case 23: return JSValue(); // Undefined is as close to null as JSON gets
+            case 25: return JSValue(half_to_double(uint16_t(arg)));
+            case 26: return JSValue(double(std::bit_cast<float>(uint32_t(arg))));
+            case 27: return JSValue(std::bit_cast<double>(arg));
+        }
+        throw sjson_parse_error::invalid_cbor("simple value " + std::to_string(arg) + " has no JSON equivalent");
+    }
+    // Skipped containers only hold a reference and a path part if they're where the skipping started
+    void CBORDecoder::start(Parse& parse, bool is_array, uint64_t items, bool indefinite) {
+        Frame frame {items, indefinite, !is_array};
+        if (frames.has_top() && frames.top().skipped)
+            frame.skipped = true;
+        else if (!parse.begin_container(is_array))
+            frame.skipped = frame.skip_root = true;
+        frames.push(frame);
+    }
+    // A break can only end an indefinite container between members
+    void CBORDecoder::end(Parse& parse) {
+        const auto frame = frames.top();
+        if (frame.indefinite && frame.map && !frame.key_next) throw sjson_parse_error::invalid_cbor("map ended before a value");
+        frames.pop();
+        if (frame.skip_root)
+            parse.end_skipped();
+        else if (!frame.skipped)
+            parse.end_container();
+    }
+} // namespace SJSON
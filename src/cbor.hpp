@@ -0,0 +1,56 @@
+#pragma once
+#include "options.hpp"
+#include "util.hpp"
+#include "value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace SJSON {
+    /*
+        Encodes values as CBOR (RFC 8949) with definite lengths and the smallest heads, iteratively like Writer
+        Integers stay integers, numbers are written as floats when that's exact, raw numbers lose their extra digits as doubles
+        Parse reads it back with Format::CBOR
+    */
+    class CBORWriter {
+    protected:
+        static void head(std::string& out, uint8_t major, uint64_t arg);
+        static void scalar(std::string& out, const JSValue& value);
+
+    public:
+        static void write(std::string& out, const JSValue& value); // Appends to out
+        static std::string to_string(const JSValue& value);
+    };
+
+    class Parse;
+
+    /*
+        Reads CBOR into a Parse through the same building blocks as the JSON grammar, so projection and listeners work alike
+        Items can be cut off anywhere between chunks
+    */
+    class CBORDecoder {
+    protected:
+        // A container that's still being read, skipped ones are only counted through
+        struct Frame {
+            uint64_t remaining = 0; // Items left, keys and values both count
+            bool indefinite = false;
+            bool map = false;
+            bool key_next = true;
+            bool skipped = false;
+            bool skip_root = false; // The skipped container that holds a path part and a reference
+        };
+        VectorStack<Frame> frames;
+        std::string pending; // An item cut off at the end of a chunk
+        size_t needed = 0;   // Bytes the cut off item needs at least
+
+        size_t item(Parse& parse, std::string_view src); // Bytes used, 0 if the item doesn't fit yet
+        static JSValue scalar(const ParseOptions& options, int major, int info, uint64_t arg, std::string_view payload);
+        void start(Parse& parse, bool is_array, uint64_t items, bool indefinite);
+        void end(Parse& parse);
+        size_t ended(Parse& parse, size_t size);
+
+    public:
+        void decode(Parse& parse, std::string_view src, bool eof);
+    };
+} // namespace SJSON
@@ -0,0 +1,282 @@
+#include "cursor.hpp"
+#include "lexer.hpp"
+#include "sjson.hpp"
+#include "syntax.hpp"
+#include "util.hpp"
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+namespace SJSON {
+    // Cursor
+    Cursor::Cursor(std::string_view src, ParseOptions options):
+        src(src),
+        options(options) {
+        if (options.format != Format::JSON) throw std::logic_error("Cursor: only JSON can be navigated");
+        if (src.size() >= simd_threshold) index.build(src);
+    }
+    void Cursor::skip_whitespace() {
+        if (!index.empty()) {
+            i = index.next_non_whitespace(i);
+            return;
+        }
+        while (i < src.size() && is_whitespace(src[i])) i++;
+    }
+    // Tokens stay views into the buffer, only escapes make them own their text
+    Token Cursor::read() {
+        Token token;
+        while (i < src.size()) {
+            if (!index.empty()) {
+                if (token.is_unresolved()) {
+                    if (const auto next = index.next_non_whitespace(i); next != i) {
+                        i = next;
+                        continue;
+                    }
+                } else if (token.is_string_body()) {
+                    if (const auto next = index.next_string_char(i); next != i) {
+                        token.push(&src[i], next - i);
+                        i = next;
+                        continue;
+                    }
+                }
+            }
+            if (!token.consume(&src[i])) return token;
+            i++;
+        }
+        if (token.is_unresolved()) throw sjson_parse_error::unexpected_eof();
+        return token;
+    }
+    // Depth is how many of the value's containers were already opened
+    void Cursor::skip_value(size_t depth) {
+        skipper.start(depth);
+        if (!skipper.skip(src, i, index) && !skipper.can_end())
+            throw sjson_parse_error::unexpected_eof();
+    }
+    // Whatever of the last value handed out the caller didn't read gets skipped
+    void Cursor::settle(size_t depth, size_t pending) {
+        if (this->depth > depth) {
+            skip_value(this->depth - depth);
+            this->depth = depth;
+        } else if (i == pending) {
+            skip_value();
+        }
+    }
+    CursorValue Cursor::root() {
+        skip_whitespace();
+        return CursorValue(this, i);
+    }
+    bool Cursor::at_end() {
+        skip_whitespace();
+        return i == src.size();
+    }
+
+    // CursorValue
+    CursorValue::CursorValue(Cursor* cursor, size_t start):
+        cursor(cursor),
+        start(start) {}
+    void CursorValue::check() const {
+        if (!cursor || cursor->i != start) throw sjson_parse_error::value_consumed();
+    }
+    Token CursorValue::scalar(const char* expected) {
+        check();
+        auto token = cursor->read();
+        if (!token.is_value()) throw sjson_parse_error::incorrect_type(expected, token.src());
+        return token;
+    }
+    JSValueType CursorValue::type() const {
+        check();
+        if (start == cursor->src.size()) throw sjson_parse_error::unexpected_eof();
+        switch (cursor->src[start]) {
+            case '{': return JSValueType::Object;
+            case '[': return JSValueType::Array;
+            case '"': return JSValueType::String;
+            case 't':
+            case 'f': return JSValueType::Boolean;
+            case 'n': return JSValueType::Null;
+            default: return JSValueType::Number;
+        }
+    }
+    bool CursorValue::is_null() {
+        if (type() != JSValueType::Null) return false;
+        const auto token = scalar("null");
+        if (token.type != TokenType::Keyword || token.to_keyword() != Keywords::Null)
+            throw sjson_parse_error::incorrect_type("null", token.src());
+        return true;
+    }
+    int64_t CursorValue::get_int64() {
+        const auto token = scalar("an integer");
+        const auto text = token.src();
+        int64_t value = 0;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (token.type != TokenType::Number || ec != std::errc() || ptr != text.data() + text.size())
+            throw sjson_parse_error::incorrect_type("an integer", text);
+        return value;
+    }
+    uint64_t CursorValue::get_uint64() {
+        const auto token = scalar("an unsigned integer");
+        const auto text = token.src();
+        uint64_t value = 0;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (token.type != TokenType::Number || ec != std::errc() || ptr != text.data() + text.size())
+            throw sjson_parse_error::incorrect_type("an unsigned integer", text);
+        return value;
+    }
+    double CursorValue::get_double() {
+        const auto token = scalar("a number");
+        if (token.type != TokenType::Number) throw sjson_parse_error::incorrect_type("a number", token.src());
+        return to_double(token.number_src(cursor->options));
+    }
+    bool CursorValue::get_bool() {
+        const auto token = scalar("a boolean");
+        if (token.type == TokenType::Keyword) {
+            switch (token.to_keyword()) {
+                case Keywords::True: return true;
+                case Keywords::False: return false;
+                case Keywords::Null: break;
+            }
+        }
+        throw sjson_parse_error::incorrect_type("a boolean", token.src());
+    }
+    std::string_view CursorValue::get_string_view() {
+        auto token = scalar("a string");
+        if (token.type != TokenType::String) throw sjson_parse_error::incorrect_type("a string", token.src());
+        cursor->string = std::move(token);
+        return cursor->string.string_body(cursor->options.validate_utf8);
+    }
+    CursorObject CursorValue::get_object() {
+        check();
+        const auto token = cursor->read();
+        if (token.type != TokenType::Operator || token.to_operator() != Operators::ObjectStart)
+            throw sjson_parse_error::incorrect_type("an object", token.src());
+        return CursorObject(cursor, ++cursor->depth, cursor->i);
+    }
+    CursorArray CursorValue::get_array() {
+        check();
+        const auto token = cursor->read();
+        if (token.type != TokenType::Operator || token.to_operator() != Operators::ArrayStart)
+            throw sjson_parse_error::incorrect_type("an array", token.src());
+        return CursorArray(cursor, ++cursor->depth);
+    }
+    std::string_view CursorValue::raw() {
+        check();
+        cursor->skip_value();
+        return cursor->src.substr(start, cursor->i - start);
+    }
+    JSValue CursorValue::to_value() {
+        const auto options = cursor->options;
+        return Parse::string(std::string(raw()), options);
+    }
+
+    // CursorObject
+    CursorObject::CursorObject(Cursor* cursor, size_t depth, size_t begin_at):
+        cursor(cursor),
+        depth(depth),
+        begin_at(begin_at),
+        key_at(begin_at) {}
+    void CursorObject::rewind() {
+        cursor->i = begin_at;
+        cursor->depth = depth;
+        pending = std::string_view::npos;
+        finished = false;
+    }
+    bool CursorObject::next(CursorField& field) {
+        if (finished) return false;
+        cursor->settle(depth, pending);
+        pending = std::string_view::npos;
+        while (true) {
+            cursor->skip_whitespace();
+            key_at = cursor->i;
+            auto token = cursor->read();
+            switch (grammar_step(Context::Object, token, false)) {
+                case Step::Skip: continue;
+                case Step::EndObject:
+                    cursor->depth--;
+                    finished = true;
+                    return false;
+                case Step::Key: {
+                    cursor->key = std::move(token);
+                    field.key = cursor->key.string_body(cursor->options.validate_utf8);
+                    // Colons are skipped like Parse does, the value starts right after them
+                    cursor->skip_whitespace();
+                    while (cursor->i < cursor->src.size() && cursor->src[cursor->i] == ':') {
+                        cursor->i++;
+                        cursor->skip_whitespace();
+                    }
+                    if (cursor->i == cursor->src.size()) throw sjson_parse_error::unexpected_eof();
+                    if (const char c = cursor->src[cursor->i]; is_operator(c) && c != '[' && c != '{')
+                        throw sjson_parse_error::unexpected_token(std::string_view(&cursor->src[cursor->i], 1));
+                    pending = cursor->i;
+                    field.value = CursorValue(cursor, pending);
+                    return true;
+                }
+                default: throw sjson_internal_parse_error::invalid_token_type("CursorObject::next()");
+            }
+        }
+    }
+    CursorObject::iterator CursorObject::begin() {
+        return iterator(this);
+    }
+    CursorObject::iterator CursorObject::end() {
+        return iterator();
+    }
+    std::optional<CursorValue> CursorObject::find(std::string_view key) {
+        CursorField field;
+        if (finished) rewind();
+        const auto origin = key_at;
+        while (next(field)) {
+            if (field.key == key) return field.value;
+        }
+        // Members up to and including the one the search started from
+        rewind();
+        while (next(field) && key_at <= origin) {
+            if (field.key == key) return field.value;
+        }
+        return std::nullopt;
+    }
+    CursorValue CursorObject::operator[](std::string_view key) {
+        if (auto value = find(key)) return *value;
+        throw std::out_of_range("CursorObject::operator[](): no member '" + std::string(key) + "'");
+    }
+    void CursorObject::skip() {
+        CursorField field;
+        while (next(field));
+    }
+
+    // CursorArray
+    CursorArray::CursorArray(Cursor* cursor, size_t depth):
+        cursor(cursor),
+        depth(depth) {}
+    bool CursorArray::next(CursorValue& value) {
+        if (finished) return false;
+        cursor->settle(depth, pending);
+        pending = std::string_view::npos;
+        while (true) {
+            cursor->skip_whitespace();
+            if (cursor->i == cursor->src.size()) throw sjson_parse_error::unexpected_eof();
+            // Anything but a bracket that opens an element goes through the same grammar as Parse
+            if (const char c = cursor->src[cursor->i]; is_operator(c) && c != '[' && c != '{') {
+                switch (grammar_step(Context::Array, cursor->read(), false)) {
+                    case Step::Skip: continue;
+                    case Step::EndArray:
+                        cursor->depth--;
+                        finished = true;
+                        return false;
+                    default: throw sjson_internal_parse_error::invalid_token_type("CursorArray::next()");
+                }
+            }
+            pending = cursor->i;
+            value = CursorValue(cursor, pending);
+            return true;
+        }
+    }
+    CursorArray::iterator CursorArray::begin() {
+        return iterator(this);
+    }
+    CursorArray::iterator CursorArray::end() {
+        return iterator();
+    }
+    void CursorArray::skip() {
+        CursorValue value;
+        while (next(value));
+    }
+} // namespace SJSON
@@ -0,0 +1,177 @@
+#pragma once
+#include "options.hpp"
+#include "simd.hpp"
+#include "skip.hpp"
+#include "token.hpp"
+#include "value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+namespace SJSON {
+    class Cursor;
+    class CursorObject;
+    class CursorArray;
+
+    // A value the cursor is sitting on, nothing is lexed until one of its getters is called
+    class CursorValue {
+    protected:
+        friend class Cursor;
+        friend class CursorObject;
+        friend class CursorArray;
+        Cursor* cursor = nullptr;
+        size_t start = 0;
+
+        CursorValue(Cursor* cursor, size_t start);
+        void check() const;
+        Token scalar(const char* expected);
+
+    public:
+        CursorValue() = default;
+
+        JSValueType type() const; // Only looks at the first byte
+        bool is_null(); // Only moves past the value if it's null
+        int64_t get_int64();
+        uint64_t get_uint64();
+        double get_double();
+        bool get_bool();
+        std::string_view get_string_view(); // Points into the buffer unless it had escapes, then it lives until the next string is read
+        CursorObject get_object();
+        CursorArray get_array();
+        std::string_view raw(); // Skips the value and returns its source text
+        JSValue to_value(); // Builds the whole value like Parse would
+    };
+
+    struct CursorField {
+        std::string_view key; // Lives until the next key is read
+        CursorValue value;
+    };
+
+    /*
+        Members are read as the object is iterated, anything the caller skips over is scanned past without being lexed
+        Iterating or looking up again after the object ended starts from its beginning
+    */
+    class CursorObject {
+    protected:
+        friend class CursorValue;
+        Cursor* cursor = nullptr;
+        size_t depth = 0;
+        size_t begin_at = 0;               // First byte after the opening bracket
+        size_t key_at = 0;                 // Where the last key started
+        size_t pending = std::string_view::npos; // Start of the last value handed out
+        bool finished = false;
+
+        CursorObject(Cursor* cursor, size_t depth, size_t begin_at);
+        void rewind();
+
+    public:
+        class iterator {
+        protected:
+            CursorObject* object = nullptr;
+            CursorField field;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = CursorField;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            inline iterator(CursorObject* object):
+                object(object) { ++*this; }
+
+            inline const CursorField& operator*() const { return field; }
+            inline const CursorField* operator->() const { return &field; }
+            inline iterator& operator++() {
+                if (!object->next(field)) object = nullptr;
+                return *this;
+            }
+            inline bool operator==(const iterator& it) const { return object == it.object; }
+        };
+
+        CursorObject() = default;
+
+        bool next(CursorField& field); // False once the object ended
+        iterator begin();
+        iterator end();
+        std::optional<CursorValue> find(std::string_view key); // Searches the members after the current one first, then wraps around
+        CursorValue operator[](std::string_view key); // Throws std::out_of_range if there's no such member
+        void skip(); // Moves past the rest of the object
+    };
+
+    class CursorArray {
+    protected:
+        friend class CursorValue;
+        Cursor* cursor = nullptr;
+        size_t depth = 0;
+        size_t pending = std::string_view::npos;
+        bool finished = false;
+
+        CursorArray(Cursor* cursor, size_t depth);
+
+    public:
+        class iterator {
+        protected:
+            CursorArray* array = nullptr;
+            CursorValue value;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = CursorValue;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            inline iterator(CursorArray* array):
+                array(array) { ++*this; }
+
+            inline CursorValue operator*() const { return value; }
+            inline iterator& operator++() {
+                if (!array->next(value)) array = nullptr;
+                return *this;
+            }
+            inline bool operator==(const iterator& it) const { return array == it.array; }
+        };
+
+        CursorArray() = default;
+
+        bool next(CursorValue& value); // False once the array ended
+        iterator begin();
+        iterator end();
+        void skip();
+    };
+
+    /*
+        On-demand reading of a document that's already in memory
+        Values are lexed with the same tokens as Parse only when a getter asks for them, the cursor only moves forward
+        (except for lookups that wrap around an object) and the buffer has to outlive it
+    */
+    class Cursor {
+    protected:
+        friend class CursorValue;
+        friend class CursorObject;
+        friend class CursorArray;
+        std::string_view src;
+        ParseOptions options;
+        size_t i = 0;
+        size_t depth = 0; // Containers opened and not finished yet
+        StructuralIndex index;
+        Skipper skipper;
+        Token key;    // Keeps the last key alive if it had escapes
+        Token string; // Same for the last string
+
+        void skip_whitespace();
+        Token read();
+        void skip_value(size_t depth = 0);
+        void settle(size_t depth, size_t pending);
+
+    public:
+        Cursor(std::string_view src, ParseOptions options = {});
+        Cursor(const Cursor&) = delete;
+        Cursor& operator=(const Cursor&) = delete;
+        ~Cursor() = default;
+
+        CursorValue root();
+        bool at_end(); // Nothing but whitespace is left
+    };
+} // namespace SJSON
@@ -0,0 +1,113 @@
+#include "events.hpp"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace SJSON {
+    void Events::scalar(const Token& token) {
+        switch (token.type) {
+            case TokenType::Keyword: {
+                switch (token.to_keyword()) {
+                    case Keywords::Null: return handler->null();
+                    case Keywords::True: return handler->boolean(true);
+                    case Keywords::False: return handler->boolean(false);
+                }
+                break;
+            }
+            case TokenType::Number: return handler->parsed_number(token.src(), parse_number(token.src(), options.raw_numbers));
+            case TokenType::String: return handler->string(token.string_body(options.validate_utf8));
+            default: break;
+        }
+        throw sjson_internal_parse_error::invalid_token_eval();
+    }
+    void Events::parse_chunk() {
+        while (true) {
+            auto token = read_token();
+            if (token.is_unresolved()) {
+                if (is_eof() && !contexts.empty())
+                    throw sjson_parse_error::unexpected_eof();
+                break;
+            }
+            if (contexts.empty())
+                throw sjson_parse_error::unexpected_data();
+            const auto context = contexts.top();
+            switch (grammar_step(context, token, contexts.has_prev() && contexts.prev() == Context::Object)) {
+                case Step::Skip:
+                case Step::Colon:
+                    break;
+                case Step::Key:
+                    handler->key(token.string_body(options.validate_utf8));
+                    contexts.push(Context::Value);
+                    break;
+                case Step::Scalar:
+                    scalar(token);
+                    if (context == Context::Value) contexts.pop();
+                    break;
+                case Step::StartObject:
+                case Step::StartArray: {
+                    const bool is_array = token.to_operator() == Operators::ArrayStart;
+                    if (is_array)
+                        handler->start_array();
+                    else
+                        handler->start_object();
+                    // A value being determined becomes the container, array elements are new values
+                    if (context == Context::Value) contexts.pop();
+                    contexts.push(is_array ? Context::Array : Context::Object);
+                    break;
+                }
+                case Step::EndObject:
+                    handler->end_object();
+                    contexts.pop();
+                    break;
+                case Step::EndArray:
+                    handler->end_array();
+                    contexts.pop();
+                    break;
+            }
+        }
+    }
+
+    Events::Events(JSONStream&& src, Handler& handler, ParseOptions options):
+        Lexer(std::move(src)),
+        handler(&handler),
+        options(options),
+        contexts({Context::Value}) {
+        if (options.format != Format::JSON) throw std::logic_error("Events: only JSON has events");
+    }
+    Events::Events(Handler& handler, ParseOptions options):
+        Events(JSONStream(), handler, options) {
+        pushed = true;
+    }
+
+    void Events::string(std::string src, Handler& handler, ParseOptions options) {
+        Events events(handler, options);
+        events.use_chunk(std::move(src));
+        events.parse_chunk();
+        events.finish(); // Simulate end of stream
+    }
+    void Events::stream(JSONStream&& src, Handler& handler, ParseOptions options) {
+        Events(std::move(src), handler, options).all();
+    }
+    bool Events::next() {
+        if (pushed) throw std::logic_error("Events::next(): push parses are fed, not streamed");
+        use_chunk(istream());
+        parse_chunk(); // Parse stream even if eof
+        return !is_eof();
+    }
+    void Events::all() {
+        while (next());
+    }
+    Events& Events::feed(std::string_view data) {
+        if (data.empty()) return *this; // Would look like the end of input
+        use_chunk(data);
+        parse_chunk();
+        return *this;
+    }
+    void Events::finish() {
+        use_chunk(std::string_view());
+        parse_chunk();
+    }
+    size_t Events::depth() const noexcept {
+        return contexts.size();
+    }
+} // namespace SJSON
@@ -0,0 +1,59 @@
+#pragma once
+#include "lexer.hpp"
+#include "options.hpp"
+#include "util.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace SJSON {
+    /*
+        Receives a parse as events instead of a JSValue, override whatever's needed
+        Strings and numbers are views that only live until the call returns, numbers are their validated source text
+    */
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+
+        virtual void start_object() {}
+        virtual void key(std::string_view key) {}
+        virtual void end_object() {}
+        virtual void start_array() {}
+        virtual void end_array() {}
+        virtual void string(std::string_view value) {}
+        virtual void number(std::string_view src) {}
+        // Every number comes through here first already parsed by parse_number(), by default it's only passed on as text
+        virtual void parsed_number(std::string_view src, const ParsedNumber& value) { number(src); }
+        virtual void boolean(bool value) {}
+        virtual void null() {}
+    };
+
+    // Same tokenizer and auto-correction as Parse but nothing is built, every token goes straight to the handler
+    class Events : protected Lexer {
+    protected:
+        Handler* handler;
+        ParseOptions options;
+        VectorStack<Context> contexts;
+        bool pushed = false;
+
+        void scalar(const Token& token);
+        void parse_chunk();
+
+    public:
+        Events(JSONStream&& src, Handler& handler, ParseOptions options = {});
+        explicit Events(Handler& handler, ParseOptions options = {}); // Push parse, input comes from feed()
+        Events(const Events&) = delete;
+        Events& operator=(const Events&) = delete;
+        Events(Events&&) noexcept = default;
+        Events& operator=(Events&&) noexcept = default;
+        ~Events() = default;
+
+        static void string(std::string src, Handler& handler, ParseOptions options = {});
+        static void stream(JSONStream&& src, Handler& handler, ParseOptions options = {});
+        bool next();
+        void all();
+        Events& feed(std::string_view data); // Same as Parse::feed()
+        void finish();
+        size_t depth() const noexcept; // Values still open
+    };
+} // namespace SJSON
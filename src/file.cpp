@@ -0,0 +1,97 @@
+#include "file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define SJSON_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace SJSON {
+    MappedFile::MappedFile(const std::string& path, bool huge_pages) {
+#ifdef SJSON_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "MappedFile: can't open " + path);
+        struct stat info;
+        if (::fstat(fd, &info) < 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "MappedFile: can't stat " + path);
+        }
+        length = size_t(info.st_size);
+        if (length) {
+            void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                const int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "MappedFile: can't map " + path);
+            }
+            data = static_cast<const char*>(mapping);
+            // Just hints, so whether they're taken doesn't matter
+            ::madvise(mapping, length, MADV_SEQUENTIAL);
+    #ifdef MADV_HUGEPAGE
+            if (huge_pages) ::madvise(mapping, length, MADV_HUGEPAGE);
+    #endif
+        }
+        ::close(fd); // The mapping keeps the file alive
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::system_error(errno, std::generic_category(), "MappedFile: can't open " + path);
+        std::ostringstream out;
+        out << in.rdbuf();
+        buffer = std::move(out).str();
+        data = buffer.data();
+        length = buffer.size();
+#endif
+    }
+    MappedFile::MappedFile(MappedFile&& file) noexcept:
+        data(std::exchange(file.data, nullptr)),
+        length(std::exchange(file.length, 0)),
+        released(std::exchange(file.released, 0)),
+        buffer(std::move(file.buffer)) {
+        if (!buffer.empty()) data = buffer.data(); // Small strings don't keep their address
+    }
+    MappedFile& MappedFile::operator=(MappedFile&& file) noexcept {
+        if (this == &file) return *this;
+        unmap();
+        data = std::exchange(file.data, nullptr);
+        length = std::exchange(file.length, 0);
+        released = std::exchange(file.released, 0);
+        buffer = std::move(file.buffer);
+        if (!buffer.empty()) data = buffer.data();
+        return *this;
+    }
+    MappedFile::~MappedFile() {
+        unmap();
+    }
+    void MappedFile::unmap() noexcept {
+#ifdef SJSON_MMAP
+        if (data) ::munmap(const_cast<char*>(data), length);
+#endif
+        data = nullptr;
+        length = 0;
+    }
+
+    std::string_view MappedFile::view() const noexcept {
+        return std::string_view(data, length);
+    }
+    size_t MappedFile::size() const noexcept {
+        return length;
+    }
+    void MappedFile::release(size_t end) noexcept {
+#ifdef SJSON_MMAP
+        static const size_t page = size_t(::sysconf(_SC_PAGESIZE));
+        end = std::min(end, length) / page * page;
+        if (end <= released) return;
+        ::madvise(const_cast<char*>(data) + released, end - released, MADV_DONTNEED);
+        released = end;
+#endif
+    }
+} // namespace SJSON
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace SJSON {
+    /*
+        Read-only mapping of a whole file, pages are read in as they're touched and can be given back once they're parsed
+        so resident memory stays bounded even for files bigger than RAM
+        Platforms without mmap read the file into memory instead
+    */
+    class MappedFile {
+    protected:
+        const char* data = nullptr;
+        size_t length = 0;
+        size_t released = 0; // Everything before this was given back
+        std::string buffer;  // Only used without mmap
+
+        void unmap() noexcept;
+
+    public:
+        inline static constexpr size_t window = 4 << 20; // How much is parsed between releases
+
+        explicit MappedFile(const std::string& path, bool huge_pages = false); // Throws std::system_error if it can't be mapped
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& file) noexcept;
+        MappedFile& operator=(MappedFile&& file) noexcept;
+        ~MappedFile();
+
+        std::string_view view() const noexcept;
+        size_t size() const noexcept;
+        // Whole pages before end are dropped, touching them again reads them back from the file
+        void release(size_t end) noexcept;
+    };
+} // namespace SJSON
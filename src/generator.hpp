@@ -0,0 +1,95 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+namespace SJSON {
+    /*
+        Minimal lazy generator, a stand-in for std::generator which not every standard library ships yet
+        Nothing runs until it's iterated and each co_yield suspends until the iterator is advanced
+    */
+    template <typename T>
+    class Generator {
+    public:
+        struct promise_type {
+            T* current = nullptr; // Yielded values live in the coroutine frame while it's suspended
+            std::exception_ptr exception;
+
+            inline Generator get_return_object() noexcept {
+                return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            inline std::suspend_always initial_suspend() const noexcept { return {}; }
+            inline std::suspend_always final_suspend() const noexcept { return {}; }
+            inline std::suspend_always yield_value(T& value) noexcept {
+                current = std::addressof(value);
+                return {};
+            }
+            inline std::suspend_always yield_value(T&& value) noexcept {
+                current = std::addressof(value);
+                return {};
+            }
+            inline void return_void() const noexcept {}
+            inline void unhandled_exception() noexcept { exception = std::current_exception(); }
+            template <typename U>
+            std::suspend_never await_transform(U&&) = delete; // Nothing to await, values are pulled
+        };
+
+        class iterator {
+        protected:
+            std::coroutine_handle<promise_type> handle;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            inline iterator(std::coroutine_handle<promise_type> handle):
+                handle(handle) {
+                if (handle) resume();
+            }
+
+            // Errors thrown inside the generator come out of whoever resumed it
+            inline void resume() {
+                handle.resume();
+                if (auto exception = std::exchange(handle.promise().exception, nullptr)) std::rethrow_exception(exception);
+            }
+            inline T& operator*() const { return *handle.promise().current; }
+            inline T* operator->() const { return handle.promise().current; }
+            inline iterator& operator++() {
+                resume();
+                return *this;
+            }
+            inline void operator++(int) { ++*this; }
+            inline bool operator==(std::default_sentinel_t) const { return !handle || handle.done(); }
+        };
+
+        Generator() = default;
+        inline Generator(Generator&& g) noexcept:
+            handle(std::exchange(g.handle, nullptr)) {}
+        inline Generator& operator=(Generator&& g) noexcept {
+            if (this != &g) {
+                if (handle) handle.destroy();
+                handle = std::exchange(g.handle, nullptr);
+            }
+            return *this;
+        }
+        Generator(const Generator&) = delete;
+        Generator& operator=(const Generator&) = delete;
+        inline ~Generator() {
+            if (handle) handle.destroy();
+        }
+
+        // Only iterated once, the values are gone after that
+        inline iterator begin() { return iterator(handle); }
+        inline std::default_sentinel_t end() const noexcept { return {}; }
+
+    protected:
+        std::coroutine_handle<promise_type> handle;
+
+        inline explicit Generator(std::coroutine_handle<promise_type> handle) noexcept:
+            handle(handle) {}
+    };
+} // namespace SJSON
@@ -0,0 +1,88 @@
+#include "gzip.hpp"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace SJSON {
+    // zlib counts in unsigned ints
+    static uInt clamp_size(size_t size) {
+        return uInt(std::min<size_t>(size, UINT_MAX));
+    }
+
+    void GzipReader::Deleter::operator()(z_stream_s* stream) const noexcept {
+        inflateEnd(stream);
+        delete stream;
+    }
+
+    GzipReader::GzipReader(ByteReader&& compressed, bool raw_deflate, size_t buffer_size):
+        source(std::move(compressed)),
+        input(std::make_unique_for_overwrite<char[]>(std::max<size_t>(clamp_size(buffer_size), 1))),
+        buffer_size(std::max<size_t>(clamp_size(buffer_size), 1)) {
+        auto* z = new z_stream_s {};
+        // 32 detects gzip or zlib headers, negative bits mean no header at all
+        if (inflateInit2(z, raw_deflate ? -MAX_WBITS : MAX_WBITS + 32) != Z_OK) {
+            delete z;
+            throw std::runtime_error("GzipReader: can't initialize zlib");
+        }
+        stream.reset(z);
+    }
+
+    void GzipReader::refill() {
+        auto& z = *stream;
+        z.avail_in = clamp_size(source(input.get(), buffer_size));
+        z.next_in = reinterpret_cast<Bytef*>(input.get());
+        if (!z.avail_in) source_ended = true;
+    }
+    size_t GzipReader::operator()(char* data, size_t size) {
+        auto& z = *stream;
+        size = clamp_size(size);
+        if (!size) return 0;
+        z.next_out = reinterpret_cast<Bytef*>(data);
+        z.avail_out = uInt(size);
+        // Returning nothing would look like the end, so it keeps going until something's out
+        while (z.avail_out == size) {
+            if (member_ended) {
+                if (!z.avail_in && !source_ended) refill();
+                if (!z.avail_in) return 0;
+                inflateReset(&z); // Concatenated members are one stream, like gzip -d does
+                member_ended = false;
+            }
+            if (!z.avail_in && !source_ended) refill();
+            const int ret = inflate(&z, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                member_ended = true;
+            } else if (ret == Z_BUF_ERROR) {
+                // No progress, fine as long as more input's coming
+                if (source_ended) throw std::runtime_error("GzipReader: compressed data ended early");
+            } else if (ret != Z_OK) {
+                throw std::runtime_error(std::string("GzipReader: ") + (z.msg ? z.msg : "corrupt data"));
+            }
+        }
+        return size - z.avail_out;
+    }
+
+    JSONStream gzip_stream(ByteReader&& compressed, size_t chunk) {
+        return [reader = GzipReader(std::move(compressed)), chunk = std::max<size_t>(chunk, 1)]() mutable -> std::string {
+            std::string out(chunk, '\0');
+            out.resize(reader(out.data(), chunk));
+            return out;
+        };
+    }
+    std::string gzip(std::string_view src, int level) {
+        z_stream z {};
+        // 16 writes a gzip header instead of zlib's
+        if (deflateInit2(&z, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("gzip: can't initialize zlib");
+        std::string out(deflateBound(&z, uLong(src.size())), '\0');
+        z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src.data()));
+        z.avail_in = clamp_size(src.size());
+        z.next_out = reinterpret_cast<Bytef*>(out.data());
+        z.avail_out = clamp_size(out.size());
+        const int ret = deflate(&z, Z_FINISH);
+        out.resize(z.total_out);
+        deflateEnd(&z);
+        if (ret != Z_STREAM_END) throw std::runtime_error("gzip: input too big for one call");
+        return out;
+    }
+} // namespace SJSON
@@ -0,0 +1,42 @@
+#pragma once
+#include "lexer.hpp"
+#include "readahead.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct z_stream_s; // zlib's, kept out of the header
+
+namespace SJSON {
+    /*
+        Inflates gzip or zlib data (or raw deflate) read from another ByteReader, it's a ByteReader itself
+        so it can be fed to Parse directly or decompress on a ReadAhead thread
+        Memory stays at the input buffer plus zlib's window however big the archive is
+    */
+    class GzipReader {
+    protected:
+        struct Deleter {
+            void operator()(z_stream_s* stream) const noexcept;
+        };
+        std::unique_ptr<z_stream_s, Deleter> stream; // zlib points back at it, so it can't move
+        ByteReader source;
+        std::unique_ptr<char[]> input;
+        size_t buffer_size;
+        bool source_ended = false;
+        bool member_ended = false; // Another gzip member can still follow
+
+        void refill();
+
+    public:
+        explicit GzipReader(ByteReader&& compressed, bool raw_deflate = false, size_t buffer_size = 1 << 16);
+        GzipReader(GzipReader&&) noexcept = default;
+        GzipReader& operator=(GzipReader&&) noexcept = default;
+        ~GzipReader() = default;
+
+        size_t operator()(char* data, size_t size); // Throws std::runtime_error for corrupt or truncated data
+    };
+
+    JSONStream gzip_stream(ByteReader&& compressed, size_t chunk = 1 << 16); // For Parse::stream(), every chunk is a new string though
+    std::string gzip(std::string_view src, int level = 6); // Compresses into one gzip member
+} // namespace SJSON
@@ -0,0 +1,86 @@
+#include "key.hpp"
+#include <cstring>
+#include <new>
+
+namespace SJSON {
+    JSKey::Node* JSKey::make(std::string_view key, size_t hash, std::pmr::memory_resource* resource) {
+        auto node = static_cast<Node*>(resource->allocate(sizeof(Node) + key.size(), alignof(Node)));
+        new (node) Node {{1}, uint32_t(key.size()), hash, resource};
+        std::memcpy(const_cast<char*>(node->data()), key.data(), key.size());
+        return node;
+    }
+    // Keys living in an arena or any other custom resource can't be shared past it
+    bool JSKey::shareable() const noexcept {
+        return !node || node->resource == std::pmr::new_delete_resource() || node->resource == std::pmr::get_default_resource();
+    }
+    void JSKey::release() noexcept {
+        if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            const auto resource = node->resource;
+            const auto size = node->size;
+            node->~Node();
+            resource->deallocate(node, sizeof(Node) + size, alignof(Node));
+        }
+        node = nullptr;
+    }
+
+    JSKey::JSKey(std::string_view key, std::pmr::memory_resource* resource) {
+        if (!key.empty()) node = make(key, hash_of(key), resource);
+    }
+    JSKey::JSKey(const JSKey& v) {
+        if (v.shareable()) {
+            node = v.node;
+            if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            node = make(v.view(), v.hash(), std::pmr::get_default_resource());
+        }
+    }
+    JSKey& JSKey::operator=(const JSKey& v) {
+        if (node != v.node) *this = JSKey(v);
+        return *this;
+    }
+    JSKey& JSKey::operator=(JSKey&& v) noexcept {
+        if (this == &v) return *this;
+        release();
+        node = v.node;
+        v.node = nullptr;
+        return *this;
+    }
+
+    KeyTable::KeyTable(size_t max_keys):
+        max_keys(max_keys) {}
+    size_t KeyTable::slot_of(std::string_view key, size_t hash) const {
+        const size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot].node && (slots[slot].node->hash != hash || slots[slot].view() != key))
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+    void KeyTable::grow() {
+        auto old = std::move(slots);
+        slots = std::vector<JSKey>(old.empty() ? 64 : old.size() * 2);
+        for (auto& key : old)
+            if (key.node) slots[slot_of(key.view(), key.hash())] = std::move(key);
+    }
+    JSKey KeyTable::intern(std::string_view key) {
+        if (key.empty()) return JSKey();
+        const auto hash = JSKey::hash_of(key);
+        if (!slots.empty()) {
+            const auto slot = slot_of(key, hash);
+            if (slots[slot].node) return slots[slot];
+        }
+        JSKey out;
+        out.node = JSKey::make(key, hash, std::pmr::new_delete_resource());
+        if (count >= max_keys) return out;
+        if ((count + 1) * 2 > slots.size()) grow();
+        slots[slot_of(key, hash)] = out;
+        count++;
+        return out;
+    }
+    size_t KeyTable::size() const noexcept {
+        return count;
+    }
+    void KeyTable::clear() {
+        slots.clear();
+        count = 0;
+    }
+} // namespace SJSON
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SJSON {
+    /*
+        Immutable, reference counted object key
+        Copies share the same stored chars so keys out of a KeyTable compare by pointer first,
+        and the hash is computed once when the key is made
+    */
+    class JSKey {
+    protected:
+        friend class KeyTable;
+        // The chars follow the node in the same allocation
+        struct Node {
+            std::atomic<uint32_t> refs;
+            uint32_t size;
+            size_t hash;
+            std::pmr::memory_resource* resource;
+
+            inline const char* data() const noexcept { return reinterpret_cast<const char*>(this + 1); }
+        };
+        Node* node = nullptr; // Null is the empty key
+
+        static Node* make(std::string_view key, size_t hash, std::pmr::memory_resource* resource);
+        bool shareable() const noexcept;
+        void release() noexcept;
+
+    public:
+        JSKey() = default;
+        explicit JSKey(std::string_view key, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        JSKey(const JSKey& v); // Shares the key unless it lives in a resource other than the default one
+        JSKey& operator=(const JSKey& v);
+        inline JSKey(JSKey&& v) noexcept:
+            node(v.node) { v.node = nullptr; }
+        JSKey& operator=(JSKey&& v) noexcept;
+        inline ~JSKey() { release(); }
+
+        inline static size_t hash_of(std::string_view key) noexcept { return std::hash<std::string_view> {}(key); }
+
+        inline std::string_view view() const noexcept { return node ? std::string_view(node->data(), node->size) : std::string_view(); }
+        inline size_t size() const noexcept { return node ? node->size : 0; }
+        inline bool empty() const noexcept { return !size(); }
+        inline size_t hash() const noexcept { return node ? node->hash : hash_of({}); }
+        // Another handle to the same stored key even if it lives in a custom resource, which then has to outlive it
+        inline JSKey share() const noexcept {
+            JSKey out;
+            out.node = node;
+            if (node) node->refs.fetch_add(1, std::memory_order_relaxed);
+            return out;
+        }
+        inline bool same(const JSKey& v) const noexcept { return node == v.node; } // Same stored instance
+        inline std::string str() const { return std::string(view()); }
+        inline operator std::string_view() const noexcept { return view(); }
+
+        inline bool operator==(const JSKey& v) const noexcept {
+            return node == v.node || (hash() == v.hash() && view() == v.view());
+        }
+        inline bool operator==(std::string_view v) const noexcept { return view() == v; }
+        inline std::strong_ordering operator<=>(const JSKey& v) const noexcept { return view() <=> v.view(); }
+        inline std::strong_ordering operator<=>(std::string_view v) const noexcept { return view() <=> v; }
+
+        // Debug shit
+        inline friend std::ostream& operator<<(std::ostream& out, const JSKey& key) {
+            return out << key.view();
+        }
+    };
+
+    /*
+        Intern table for object keys
+        Keys made through the same table share one stored instance, which is the whole point on
+        arrays of records that repeat the same few keys millions of times
+        Interned keys are reference counted so they can safely outlive the table
+    */
+    class KeyTable {
+    protected:
+        std::vector<JSKey> slots; // Linear probing, kept at most half full
+        size_t count = 0;
+        size_t max_keys;
+
+        size_t slot_of(std::string_view key, size_t hash) const;
+        void grow();
+
+    public:
+        inline static constexpr size_t default_max_keys = 1 << 16;
+
+        KeyTable(size_t max_keys = default_max_keys); // Keys past max_keys are made but not interned
+        KeyTable(const KeyTable&) = delete;
+        KeyTable& operator=(const KeyTable&) = delete;
+        KeyTable(KeyTable&&) noexcept = default;
+        KeyTable& operator=(KeyTable&&) noexcept = default;
+        ~KeyTable() = default;
+
+        JSKey intern(std::string_view key);
+        size_t size() const noexcept;
+        void clear();
+    };
+} // namespace SJSON
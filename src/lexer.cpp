@@ -0,0 +1,68 @@
+#include "lexer.hpp"
+#include <string>
+
+namespace SJSON {
+    // End of file if stream returns an empty string
+    bool Lexer::is_eof() const noexcept {
+        return chunk.size() == 0;
+    }
+    bool Lexer::readable() const noexcept {
+        return i < chunk.size();
+    }
+    // Reset read state
+    void Lexer::use_chunk(std::string src) {
+        owned_chunk = std::move(src);
+        use_chunk(std::string_view(owned_chunk));
+    }
+    // Tokens left unfinished at the end are copied out, so the chunk only has to live until it's parsed
+    void Lexer::use_chunk(std::string_view src) {
+        if (readable()) throw sjson_internal_parse_error::new_chunk_before_finish();
+        i = 0;
+        chunk = src;
+        if (indexing && chunk.size() >= simd_threshold)
+            index.build(chunk);
+        else
+            index.clear();
+    }
+    // Move out and reset for a new streamed token
+    Token Lexer::mk_token() {
+        Token token = std::move(current_token);
+        current_token.reset();
+        return token;
+    }
+    // Tokens are views into the chunk until they straddle into the next one
+    Token Lexer::read_token() {
+        if (readable()) {
+            while (readable()) {
+                // Jump through bytes that can't change the token's state
+                if (!index.empty()) {
+                    if (current_token.is_unresolved()) {
+                        if (const auto next = index.next_non_whitespace(i); next != i) {
+                            i = next;
+                            continue;
+                        }
+                    } else if (current_token.is_string_body()) {
+                        if (const auto next = index.next_string_char(i); next != i) {
+                            current_token.push(&chunk[i], next - i);
+                            i = next;
+                            continue;
+                        }
+                    }
+                }
+                if (!current_token.consume(&chunk[i]))
+                    return mk_token();
+                i++;
+            }
+        } else if (is_eof()) {
+            // No argument represents eof (errors still work cuz tokens check validity when their value is accessed)
+            if (current_token.is_terminating())
+                return mk_token();
+        }
+        // If the current token is unfinished it has to outlive this chunk
+        if (!is_eof()) current_token.detach();
+        return Token();
+    }
+
+    Lexer::Lexer(JSONStream&& src):
+        istream(std::move(src)) {}
+} // namespace SJSON
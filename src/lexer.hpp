@@ -0,0 +1,103 @@
+#pragma once
+#include "simd.hpp"
+#include "syntax.hpp"
+#include "token.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace SJSON {
+    typedef std::move_only_function<std::string()> JSONStream;
+
+    // What the innermost unfinished value is
+    enum class Context : uint8_t {
+        Value, // Not determined yet, the root or a member's value
+        Object,
+        Array,
+    };
+    // What a token does in its context
+    enum class Step : uint8_t {
+        Skip, // Commas are ignored cuz values are handled individually
+        Colon,
+        Key,
+        Scalar,
+        StartObject,
+        StartArray,
+        EndObject,
+        EndArray,
+    };
+
+    /*
+        Grammar every parser shares so they accept (and auto-correct) exactly the same input
+        in_object is whether the value being determined belongs to an object, colons aren't valid anywhere else
+    */
+    inline Step grammar_step(Context context, const Token& token, bool in_object) {
+        switch (token.type) {
+            case TokenType::Unresolved: return Step::Skip;
+            case TokenType::Operator: break;
+            case TokenType::Keyword:
+            case TokenType::Number:
+                if (context == Context::Object) throw sjson_parse_error::unexpected_token(token.src());
+                return Step::Scalar;
+            case TokenType::String: return context == Context::Object ? Step::Key : Step::Scalar;
+        }
+        const auto op = token.to_operator();
+        switch (context) {
+            case Context::Value:
+                switch (op) {
+                    case Operators::Colon:
+                        if (!in_object) break;
+                        return Step::Colon;
+                    case Operators::ArrayStart: return Step::StartArray;
+                    case Operators::ObjectStart: return Step::StartObject;
+                    default: break;
+                }
+                break;
+            case Context::Object:
+                switch (op) {
+                    case Operators::Comma: return Step::Skip; // Objects follow a specific pattern anyways
+                    case Operators::ObjectEnd: return Step::EndObject;
+                    default: break;
+                }
+                break;
+            case Context::Array:
+                switch (op) {
+                    case Operators::Comma: return Step::Skip;
+                    case Operators::ArrayEnd: return Step::EndArray;
+                    case Operators::ArrayStart: return Step::StartArray;
+                    case Operators::ObjectStart: return Step::StartObject;
+                    default: break;
+                }
+                break;
+        }
+        throw sjson_parse_error::unexpected_token(token.src());
+    }
+
+    // Reads tokens out of a stream a chunk at a time, parsers drive it with their own state on top of grammar_step
+    class Lexer {
+    protected:
+        JSONStream istream;
+        Token current_token;
+        size_t i = 0;
+        std::string owned_chunk; // Chunks pulled from the stream, fed ones are only borrowed while they're parsed
+        std::string_view chunk;
+        StructuralIndex index;
+        bool indexing = true; // Binary input has no structure to index
+
+        bool is_eof() const noexcept;
+        bool readable() const noexcept;
+        void use_chunk(std::string src);
+        void use_chunk(std::string_view src);
+        Token mk_token();
+        Token read_token();
+
+    public:
+        Lexer(JSONStream&& src);
+        Lexer(const Lexer&) = delete;
+        Lexer& operator=(const Lexer&) = delete;
+        Lexer(Lexer&&) noexcept = default;
+        Lexer& operator=(Lexer&&) noexcept = default;
+        ~Lexer() = default;
+    };
+} // namespace SJSON
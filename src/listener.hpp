@@ -1,46 +1,232 @@
 #pragma once
+#include "key.hpp"
 #include "syntax.hpp"
+#include "token.hpp"
 #include "util.hpp"
 #include "value.hpp"
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace SJSON {
     typedef std::move_only_function<void(const JSValue& value)> JSONCallback;
+    typedef std::move_only_function<void(const sjson_parse_error& err)> JSONErrorCallback;
 
+    /*
+        Labels are compiled into a trie once when they're listened to, every pushed part moves two walks down it:
+        the exact walk follows keys and indexes, the generic walk follows keys and [] so nothing is stringified per value
+    */
     class JSPath {
     protected:
+        inline static constexpr uint32_t dead = 0; // Node 0 has no children, walks that fall off the trie end up here
+        inline static constexpr uint32_t root = 1;
+
+        struct KeyHash {
+            using is_transparent = void;
+            inline size_t operator()(const JSKey& key) const noexcept { return key.hash(); }
+            inline size_t operator()(std::string_view key) const noexcept { return JSKey::hash_of(key); }
+        };
+        struct Node {
+            std::unordered_map<JSKey, uint32_t, KeyHash, std::equal_to<>> keys;
+            std::unordered_map<size_t, uint32_t> indexes;
+            uint32_t generic = dead;
+            JSONCallback listener;
+            bool keep = false; // Built when projecting even without a listener
+        };
+        struct State {
+            uint32_t exact = dead;
+            uint32_t generic = dead;
+            bool whole = false; // Inside a listened or kept value, so everything below it is built
+        };
+        // Object keys are shared with the object they belong to, array indexes are never stringified while parsing
+        struct Part {
+            JSKey key;
+            size_t index = 0;
+            bool is_index = false;
+            State state {};
+            size_t elements = 0; // Counted here cuz dropped elements leave their array
+
+            inline std::string to_string() const { return is_index ? std::to_string(index) : key.str(); }
+            inline bool operator==(const Part& v) const { return is_index == v.is_index && (is_index ? index == v.index : key == v.key); }
+        };
         bool drop_generics;
-        VectorStack<std::string> parts;
-        std::unordered_map<std::string, JSONCallback> listeners;
+        bool project;
+        KeyTable* interned; // Where label keys come from if the parse interns its keys, so matching them compares pointers
+        VectorStack<Part> parts;
+        std::deque<Node> nodes; // Deque so callbacks stay put if they listen to more paths
+        size_t labels = 0;
 
-        inline static bool needs_escape(const std::string& part) {
+        inline static bool needs_escape(std::string_view part) {
             for (char c : part) {
-                if (!letters_set.contains(c)) return true;
+                if (!is_letter(c)) return true;
             }
             return false;
         }
-        inline static bool is_index(const std::string& part) {
+        inline static bool is_index(std::string_view part) {
             return is_valid_integer(part);
         }
-        inline bool call_if(const std::string& key, const JSValue& value) {
-            if (listeners.contains(key)) {
-                listeners.at(key)(value);
-                return true;
+        // Numeric keys are matched like indexes, unless they have leading zeros that an index can't have
+        inline static bool as_index(std::string_view part, size_t& index) {
+            if (!is_index(part) || (part.size() > 1 && part[0] == '0')) return false;
+            std::from_chars(part.data(), part.data() + part.size(), index);
+            return true;
+        }
+
+        // Walks
+        inline uint32_t exact_child(uint32_t node, size_t index) const {
+            const auto& children = nodes[node].indexes;
+            const auto it = children.find(index);
+            return it == children.end() ? dead : it->second;
+        }
+        inline uint32_t key_child(uint32_t node, const JSKey& key) const {
+            const auto& children = nodes[node].keys;
+            const auto it = children.find(key);
+            return it == children.end() ? dead : it->second;
+        }
+        inline bool is_target(const State& state) const {
+            const auto& exact = nodes[state.exact];
+            const auto& generic = nodes[state.generic];
+            return exact.listener || exact.keep || generic.listener || generic.keep;
+        }
+        inline State advance(const State& from, const Part& part) const {
+            const bool whole = from.whole || is_target(from);
+            if (from.exact == dead && from.generic == dead) return {dead, dead, whole};
+            if (part.is_index) return {exact_child(from.exact, part.index), nodes[from.generic].generic, whole};
+            size_t index;
+            if (as_index(part.key, index)) return {exact_child(from.exact, index), nodes[from.generic].generic, whole};
+            if (is_index(part.key)) return {key_child(from.exact, part.key), nodes[from.generic].generic, whole};
+            return {key_child(from.exact, part.key), key_child(from.generic, part.key), whole};
+        }
+        inline void push(Part part) {
+            if (labels && parts.has_top()) part.state = advance(parts.top().state, part);
+            parts.push(std::move(part));
+        }
+        // Listening in the middle of a parse has to catch the parts already pushed up
+        inline void rewalk() {
+            parts[0].state = {root, root};
+            for (size_t i = 1; i < length(); i++) parts[i].state = advance(parts[i - 1].state, parts[i]);
+        }
+
+        // Compiling
+        inline uint32_t make_node() {
+            nodes.emplace_back();
+            return uint32_t(nodes.size() - 1);
+        }
+        inline uint32_t insert_index(uint32_t node, size_t index) {
+            if (const auto child = exact_child(node, index)) return child;
+            const auto child = make_node();
+            nodes[node].indexes[index] = child;
+            return child;
+        }
+        inline uint32_t insert_key(uint32_t node, std::string_view key) {
+            size_t index;
+            if (as_index(key, index)) return insert_index(node, index);
+            if (const auto it = nodes[node].keys.find(key); it != nodes[node].keys.end()) return it->second;
+            const auto child = make_node();
+            nodes[node].keys.emplace(interned ? interned->intern(key) : JSKey(key, std::pmr::new_delete_resource()), child);
+            return child;
+        }
+        inline uint32_t insert_generic(uint32_t node) {
+            if (nodes[node].generic) return nodes[node].generic;
+            const auto child = make_node();
+            nodes[node].generic = child;
+            return child;
+        }
+        // Quoted parts are read as JSON strings, so escapes in them mean the same thing as in the document
+        inline static size_t read_quoted(std::string_view label, size_t i, std::string& out) {
+            Token token;
+            size_t end = i;
+            while (end < label.size() && token.consume(label.data() + end)) end++;
+            if (end == label.size() || label[end] != ']' || token.type != TokenType::String) return std::string_view::npos;
+            out = token.string_body();
+            return end;
+        }
+        // Dead for a label no path is ever written as, which like any other path nothing ever matches
+        inline uint32_t compile(std::string_view label) {
+            uint32_t node = root;
+            std::string key;
+            for (size_t i = 0; i < label.size();) {
+                if (label[i] == '[') {
+                    if (i + 1 < label.size() && label[i + 1] == '"') {
+                        i = read_quoted(label, i + 1, key);
+                        if (i == std::string_view::npos) return dead;
+                        node = insert_key(node, key);
+                        i++;
+                        continue;
+                    }
+                    const auto end = label.find(']', i);
+                    if (end == std::string_view::npos) return dead;
+                    const auto part = label.substr(i + 1, end - i - 1);
+                    if (part.empty())
+                        node = insert_generic(node);
+                    else if (is_index(part))
+                        node = insert_key(node, part);
+                    else
+                        return dead;
+                    i = end + 1;
+                    continue;
+                }
+                if (label[i] == '.') {
+                    if (i == 0) return dead;
+                    i++;
+                }
+                const auto end = std::min(label.find_first_of(".[", i), label.size());
+                if (end == i) return dead;
+                node = insert_key(node, label.substr(i, end - i));
+                i = end;
             }
-            return false;
+            return node;
         }
 
     public:
-        inline JSPath(bool drop_generics):
+        inline JSPath(bool drop_generics, bool project = false, KeyTable* interned = nullptr):
             drop_generics(drop_generics),
-            parts({"JSON"}) {} // This is only here to match with the references stack
+            project(project),
+            interned(interned),
+            parts({Part {.state = {root, root}}}), // This is only here to match with the references stack
+            nodes(2) {}
         ~JSPath() = default;
 
-        inline constexpr void push(std::string part) { parts.push(std::move(part)); }
-        inline void push(size_t part) { parts.push(std::to_string(part)); }
+        // Back to just the root for another document, listeners stay
+        inline void reset() {
+            parts.clear();
+            parts.push(Part {.state = {root, root}});
+        }
+        // For a range of an array that starts further in
+        inline void skip_elements(size_t count) {
+            parts.top().elements += count;
+        }
+        // Calls listeners over a value that was built without them, children before their parents like a parse would
+        inline void replay(JSValue& value) {
+            if (!labels) return;
+            if (const auto& state = parts.top().state; state.exact == dead && state.generic == dead) return; // Nothing below is listened to
+            if (value.is_object()) {
+                for (auto& [key, member] : value.object()) {
+                    push(key.share());
+                    replay(member);
+                    pop(member); // Only array elements are ever dropped
+                }
+            } else if (value.is_array()) {
+                auto& array = value.array();
+                size_t kept = 0;
+                for (size_t i = 0; i < array.size(); i++) {
+                    push_element();
+                    replay(array[i]);
+                    if (pop(array[i])) continue;
+                    if (kept != i) array[kept] = std::move(array[i]);
+                    kept++;
+                }
+                array.erase(array.begin() + kept, array.end());
+            }
+        }
+
+        inline void push(JSKey part) { push(Part {std::move(part)}); }
+        inline void push(size_t part) { push(Part {JSKey(), part, true}); }
+        inline void push_element() { push(parts.top().elements++); } // Next index of the array on top
         inline constexpr bool pop() {
             parts.pop();
             return false;
@@ -57,34 +243,67 @@ namespace SJSON {
         inline std::string to_string(bool is_generic = false) const {
             std::string out;
             for (size_t i = 1; i < length(); i++) {
-                auto& part = parts[i];
-                if (needs_escape(part)) {
-                    if (is_index(part)) {
+                const auto& part = parts[i];
+                const auto key = part.key.view();
+                if (part.is_index || needs_escape(key)) {
+                    // Numeric keys are matched like indexes
+                    if (part.is_index || is_index(key)) {
                         if (is_generic)
                             out += "[]";
                         else
-                            out += "[" + part + "]";
+                            out += "[" + part.to_string() + "]";
                     } else {
-                        out += "[" + jsstring_escape(part) + "]";
+                        out += '[';
+                        jsstring_escape(out, key);
+                        out += ']';
                     }
                 } else {
                     if (i != 1) out += ".";
-                    out += part;
+                    out += key;
                 }
             }
             return out;
         }
-        inline void listen(std::string path, JSONCallback&& cb) {
-            if (listeners.contains(path)) return; // Disallow multiple listeners per path
-            listeners[std::move(path)] = std::move(cb);
+        inline void listen(std::string_view path, JSONCallback&& cb) {
+            const auto compiled = compile(path);
+            if (compiled == dead) return;
+            auto& node = nodes[compiled];
+            if (node.listener) return; // Disallow multiple listeners per path
+            node.listener = std::move(cb);
+            labels++;
+            rewalk();
+        }
+        // Only matters when projecting, kept values are built like listened ones
+        inline void keep(std::string_view path) {
+            const auto compiled = compile(path);
+            if (compiled == dead) return;
+            auto& node = nodes[compiled];
+            if (node.keep) return;
+            node.keep = true;
+            labels++;
+            rewalk();
         }
+        // If the value on top has to be built, when projecting only values on the way to or inside a listened or kept one are
+        inline bool wanted() const {
+            if (!project) return true;
+            const auto& state = parts.top().state;
+            return state.whole || state.exact != dead || state.generic != dead;
+        }
+        // Exact listeners win over generic ones, and only generic values are dropped to stop drop loops
         inline bool call(const JSValue& value) {
-            if (!listeners.size()) return false;
-            if (call_if(to_string(false), value)) return false;
-            return call_if(to_string(true), value) && drop_generics; // Only drop generics to stop drop loops
+            if (!labels) return false;
+            const auto& state = parts.top().state;
+            if (auto& node = nodes[state.exact]; node.listener) {
+                node.listener(value);
+                return false;
+            }
+            if (auto& node = nodes[state.generic]; node.listener) {
+                node.listener(value);
+                return drop_generics;
+            }
+            return false;
         }
-        inline constexpr std::string& operator[](size_t i) { return parts[i]; }
-        inline constexpr const std::string& operator[](size_t i) const { return parts[i]; }
+        inline std::string operator[](size_t i) const { return parts[i].to_string(); }
         // Not used but useful
         inline constexpr bool operator==(const JSPath& a) const {
             if (length() != a.length()) return false;
@@ -0,0 +1,180 @@
+#include "object.hpp"
+#include "value.hpp"
+#include <stdexcept>
+#include <type_traits>
+#include <tuple>
+
+namespace SJSON {
+    static_assert(std::is_nothrow_move_constructible_v<JSObject::Slot>, "growing the members would copy them");
+
+    bool JSObject::is_flat() const noexcept {
+        return kind != ObjectPolicy::Sorted;
+    }
+    bool JSObject::is_indexed() const noexcept {
+        return !slots.empty();
+    }
+    // Linear probing, the index is kept at most half full so there's always an empty slot
+    size_t JSObject::slot_of(std::string_view key, size_t hash) const {
+        const size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot] && (members[slots[slot] - 1].value.first.hash() != hash || members[slots[slot] - 1].value.first != key))
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+    void JSObject::index(size_t member) {
+        if (kind != ObjectPolicy::Hashed) return;
+        if (!is_indexed()) {
+            if (members.size() > hashed_threshold) reindex();
+            return;
+        }
+        if (members.size() * 2 > slots.size()) return reindex();
+        const auto& key = members[member].value.first;
+        slots[slot_of(key, key.hash())] = uint32_t(member + 1);
+    }
+    void JSObject::reindex() {
+        size_t capacity = 16;
+        while (capacity < members.size() * 2) capacity *= 2;
+        slots.assign(capacity, 0);
+        for (size_t i = 0; i < members.size(); i++)
+            slots[slot_of(members[i].value.first, members[i].value.first.hash())] = uint32_t(i + 1);
+    }
+
+    JSObject::JSObject(ObjectPolicy policy, std::pmr::memory_resource* resource):
+        kind(policy),
+        map(resource),
+        members(resource),
+        slots(resource) {}
+    JSObject::JSObject(std::pmr::memory_resource* resource):
+        JSObject(ObjectPolicy::Sorted, resource) {}
+    JSObject::JSObject(std::initializer_list<value_type> init, ObjectPolicy policy):
+        JSObject(policy) {
+        for (const auto& [k, v] : init) (*this)[k] = v;
+    }
+    JSObject::JSObject(const JSObject& v) = default;
+    JSObject::JSObject(JSObject&& v) noexcept = default;
+    JSObject::~JSObject() = default;
+    JSObject& JSObject::operator=(const JSObject& v) {
+        if (this == &v) return *this;
+        clear();
+        kind = v.kind;
+        if (!is_flat()) {
+            map = v.map;
+            return *this;
+        }
+        members = v.members;
+        if (v.is_indexed()) reindex();
+        return *this;
+    }
+    JSObject& JSObject::operator=(JSObject&& v) {
+        if (this == &v) return *this;
+        if (resource() != v.resource()) return *this = static_cast<const JSObject&>(v);
+        kind = v.kind;
+        map.swap(v.map);
+        members.swap(v.members);
+        slots.swap(v.slots);
+        v.clear();
+        return *this;
+    }
+
+    ObjectPolicy JSObject::policy() const noexcept {
+        return kind;
+    }
+    std::pmr::memory_resource* JSObject::resource() const noexcept {
+        return members.get_allocator().resource();
+    }
+    size_t JSObject::size() const noexcept {
+        return is_flat() ? members.size() : map.size();
+    }
+    bool JSObject::empty() const noexcept {
+        return size() == 0;
+    }
+    void JSObject::clear() {
+        map.clear();
+        members.clear();
+        slots.clear();
+    }
+    void JSObject::reserve(size_t n) {
+        if (is_flat()) members.reserve(n);
+    }
+
+    JSObject::iterator JSObject::begin() noexcept {
+        return is_flat() ? iterator(members.begin()) : iterator(map.begin());
+    }
+    JSObject::iterator JSObject::end() noexcept {
+        return is_flat() ? iterator(members.end()) : iterator(map.end());
+    }
+    JSObject::const_iterator JSObject::begin() const noexcept {
+        return is_flat() ? const_iterator(members.begin()) : const_iterator(map.begin());
+    }
+    JSObject::const_iterator JSObject::end() const noexcept {
+        return is_flat() ? const_iterator(members.end()) : const_iterator(map.end());
+    }
+
+    JSObject::iterator JSObject::find(std::string_view key) {
+        if (!is_flat()) return iterator(map.find(key));
+        if (is_indexed()) {
+            const auto member = slots[slot_of(key, JSKey::hash_of(key))];
+            return iterator(member ? members.begin() + (member - 1) : members.end());
+        }
+        for (auto it = members.begin(); it != members.end(); ++it)
+            if (it->value.first == key) return iterator(it);
+        return end();
+    }
+    JSObject::iterator JSObject::find(const JSKey& key) {
+        if (!is_flat()) return iterator(map.find(key));
+        if (is_indexed()) {
+            const auto member = slots[slot_of(key, key.hash())];
+            return iterator(member ? members.begin() + (member - 1) : members.end());
+        }
+        for (auto it = members.begin(); it != members.end(); ++it)
+            if (it->value.first == key) return iterator(it);
+        return end();
+    }
+    JSObject::const_iterator JSObject::find(std::string_view key) const {
+        return const_cast<JSObject*>(this)->find(key);
+    }
+    JSObject::const_iterator JSObject::find(const JSKey& key) const {
+        return const_cast<JSObject*>(this)->find(key);
+    }
+    bool JSObject::contains(std::string_view key) const {
+        return find(key) != end();
+    }
+    size_t JSObject::count(std::string_view key) const {
+        return contains(key);
+    }
+    JSValue& JSObject::at(std::string_view key) {
+        const auto it = find(key);
+        if (it == end()) throw std::out_of_range("JSObject::at(): no member '" + std::string(key) + "'");
+        return it->second;
+    }
+    const JSValue& JSObject::at(std::string_view key) const {
+        return const_cast<JSObject*>(this)->at(key);
+    }
+    JSValue& JSObject::operator[](std::string_view key) {
+        if (const auto it = find(key); it != end()) return it->second;
+        if (!is_flat())
+            return map.emplace(std::piecewise_construct, std::forward_as_tuple(key, resource()), std::forward_as_tuple()).first->second;
+        members.emplace_back(JSKey(key, resource()), JSValue());
+        index(members.size() - 1);
+        return members.back().value.second;
+    }
+    JSValue& JSObject::operator[](JSKey key) {
+        if (const auto it = find(key); it != end()) return it->second;
+        if (!is_flat())
+            return map.emplace(std::move(key), JSValue()).first->second;
+        members.emplace_back(std::move(key), JSValue());
+        index(members.size() - 1);
+        return members.back().value.second;
+    }
+    size_t JSObject::erase(std::string_view key) {
+        const auto it = find(key);
+        if (it == end()) return 0;
+        if (!is_flat()) {
+            map.erase(it.map_it);
+            return 1;
+        }
+        members.erase(it.members_it);
+        if (is_indexed()) reindex();
+        return 1;
+    }
+} // namespace SJSON
@@ -0,0 +1,159 @@
+#pragma once
+#include "key.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace SJSON {
+    class JSValue;
+    // Strings and containers allocate from whatever memory resource they were made with
+    typedef std::pmr::string JSString;
+
+    // How a JSObject stores its members
+    enum class ObjectPolicy : uint8_t {
+        Sorted, // Node based map, members are ordered by key
+        Flat,   // Contiguous members in insertion order, found with a linear scan (best for small objects)
+        Hashed, // Contiguous members in insertion order, found through an open addressing index once the object grows
+    };
+
+    /*
+        Object members behind a policy picked at construction
+        Every policy iterates the same std::pair<const JSKey, JSValue> so code walking an object doesn't care which one it has
+        Contiguous members are slots that really hold that pair, the key is shared instead of copied out of its resource when the vector grows
+    */
+    class JSObject {
+    public:
+        typedef JSKey key_type;
+        typedef JSValue mapped_type;
+        typedef std::pair<const JSKey, JSValue> value_type;
+        typedef std::pmr::map<JSKey, JSValue, std::less<>> Map;
+        struct Slot; // Defined with JSValue, see value.hpp
+        typedef std::pmr::vector<Slot> Members;
+
+        // Flat objects stay unindexed until they grow past this
+        inline static constexpr size_t hashed_threshold = 8;
+
+        template <bool Const>
+        class basic_iterator {
+        protected:
+            friend class JSObject;
+            using MapIterator = std::conditional_t<Const, Map::const_iterator, Map::iterator>;
+            using MembersIterator = std::conditional_t<Const, Members::const_iterator, Members::iterator>;
+            MapIterator map_it;
+            MembersIterator members_it;
+            bool flat = false;
+
+            inline basic_iterator(MapIterator it):
+                map_it(it) {}
+            inline basic_iterator(MembersIterator it):
+                members_it(it),
+                flat(true) {}
+
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = JSObject::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+            using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+            basic_iterator() = default;
+            // Mutable iterators convert to const ones
+            template <bool Other>
+                requires(Const && !Other)
+            inline basic_iterator(const basic_iterator<Other>& it):
+                map_it(it.map_it),
+                members_it(it.members_it),
+                flat(it.flat) {}
+
+            inline reference operator*() const { return flat ? members_it->value : *map_it; }
+            inline pointer operator->() const { return &**this; }
+            inline basic_iterator& operator++() {
+                if (flat)
+                    ++members_it;
+                else
+                    ++map_it;
+                return *this;
+            }
+            inline basic_iterator operator++(int) {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+            inline basic_iterator& operator--() {
+                if (flat)
+                    --members_it;
+                else
+                    --map_it;
+                return *this;
+            }
+            inline basic_iterator operator--(int) {
+                auto copy = *this;
+                --*this;
+                return copy;
+            }
+            inline bool operator==(const basic_iterator& it) const {
+                return flat ? members_it == it.members_it : map_it == it.map_it;
+            }
+
+            template <bool>
+            friend class basic_iterator;
+        };
+        typedef basic_iterator<false> iterator;
+        typedef basic_iterator<true> const_iterator;
+
+    protected:
+        ObjectPolicy kind;
+        Map map;
+        Members members;
+        std::pmr::vector<uint32_t> slots; // Index of a member + 1, zero is empty
+
+        bool is_flat() const noexcept;
+        bool is_indexed() const noexcept;
+        size_t slot_of(std::string_view key, size_t hash) const;
+        void index(size_t member);
+        void reindex();
+
+    public:
+        JSObject(ObjectPolicy policy = ObjectPolicy::Sorted, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+        JSObject(std::pmr::memory_resource* resource);
+        JSObject(std::initializer_list<value_type> init, ObjectPolicy policy = ObjectPolicy::Sorted);
+        JSObject(const JSObject& v);
+        JSObject& operator=(const JSObject& v);
+        JSObject(JSObject&& v) noexcept;
+        JSObject& operator=(JSObject&& v);
+        ~JSObject();
+
+        ObjectPolicy policy() const noexcept;
+        std::pmr::memory_resource* resource() const noexcept;
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        void clear();
+        void reserve(size_t n); // Only does anything for contiguous policies
+
+        iterator begin() noexcept;
+        iterator end() noexcept;
+        const_iterator begin() const noexcept;
+        const_iterator end() const noexcept;
+
+        iterator find(std::string_view key);
+        iterator find(const JSKey& key); // Compares by pointer first and reuses the key's hash
+        const_iterator find(std::string_view key) const;
+        const_iterator find(const JSKey& key) const;
+        bool contains(std::string_view key) const;
+        size_t count(std::string_view key) const;
+        JSValue& at(std::string_view key);
+        const JSValue& at(std::string_view key) const;
+        JSValue& operator[](std::string_view key); // Inserts a null member if there isn't one
+        JSValue& operator[](JSKey key);
+        size_t erase(std::string_view key);
+    };
+} // namespace SJSON
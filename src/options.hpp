@@ -0,0 +1,30 @@
+#pragma once
+#include "object.hpp"
+#include <cstdint>
+#include <memory_resource>
+
+namespace SJSON {
+    // What the input is written in
+    enum class Format : uint8_t {
+        JSON,
+        CBOR, // RFC 8949, see CBORWriter
+    };
+
+    // Everything about a parse that isn't the input itself
+    struct ParseOptions {
+        bool drop_generics = false;                    // Drop values sent to generic listeners
+        bool project = false;                          // Only build values listened to or kept, skip everything else unparsed and unvalidated
+        bool raw_numbers = false;                      // Keep the decimal text of numbers a double or 64 bit integer can't hold exactly
+        bool validate_utf8 = false;                    // Reject strings that aren't valid UTF-8, lone surrogate escapes included
+        std::pmr::memory_resource* resource = nullptr; // Where parsed values allocate from, the default resource if null
+        ObjectPolicy objects = ObjectPolicy::Sorted;   // How parsed objects store their members
+        bool intern_keys = false;                      // Share one stored instance per distinct object key
+        KeyTable* keys = nullptr;                      // Table to intern keys in, the parse's own if null (can be shared between parses)
+        bool multi_document = false;                   // Any number of root values one after another (JSON Lines, concatenated JSON)
+        Format format = Format::JSON;                  // Only Parse reads anything but JSON
+
+        inline std::pmr::memory_resource* memory() const noexcept {
+            return resource ? resource : std::pmr::get_default_resource();
+        }
+    };
+} // namespace SJSON
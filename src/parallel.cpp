@@ -0,0 +1,261 @@
+#include "parallel.hpp"
+#include "simd.hpp"
+#include "sjson.hpp"
+#include "skip.hpp"
+#include "syntax.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace SJSON {
+    ParallelParse::ParallelParse(ParseOptions options, ParallelOptions parallel):
+        options(options),
+        parallel(parallel),
+        path(options.drop_generics),
+        pool(parallel.threads) {
+        if (options.format != Format::JSON) throw std::logic_error("ParallelParse: only JSON can be split");
+        // Arenas and key tables aren't thread-safe, every thread uses its own
+        this->options.multi_document = true;
+        this->options.resource = nullptr;
+        this->options.keys = nullptr;
+        // Listeners are called once values are delivered, so the threads never drop anything themselves
+        this->options.drop_generics = false;
+        workers.resize(pool.size());
+    }
+    ParallelParse::~ParallelParse() = default;
+
+    ParallelParse& ParallelParse::documents(JSONCallback&& cb) {
+        on_document = std::move(cb);
+        return *this;
+    }
+    // The threads' parses are remade whenever something they're made with changes
+    ParallelParse& ParallelParse::resync(JSONErrorCallback&& cb) {
+        on_error = std::move(cb);
+        for (auto& worker : workers) worker.parse.reset();
+        return *this;
+    }
+    ParallelParse& ParallelParse::listen(std::string label, JSONCallback&& cb) {
+        path.listen(label, std::move(cb));
+        return keep(std::move(label));
+    }
+    ParallelParse& ParallelParse::keep(std::string label) {
+        path.keep(label);
+        kept.push_back(std::move(label));
+        for (auto& worker : workers) worker.parse.reset();
+        return *this;
+    }
+
+    void ParallelParse::run(Batch& batch, size_t worker) {
+        auto& state = workers[worker];
+        if (!cancelled) {
+            try {
+                if (!state.parse) {
+                    state.parse = std::make_unique<Parse>(options);
+                    // Documents are moved out of the parse instead of copied, it resets for the next one anyways
+                    state.parse->documents([&state](const JSValue&) {
+                        state.batch->documents.push_back(std::move(state.parse->value));
+                    });
+                    if (on_error) {
+                        state.parse->resync([&state](const sjson_parse_error& err) {
+                            if (state.batch->first != std::string_view::npos) throw err; // Arrays don't have lines to resync at
+                            state.batch->errors.emplace_back(state.batch->documents.size(), err);
+                        });
+                    }
+                    for (const auto& label : kept) state.parse->keep(label);
+                }
+                state.batch = &batch;
+                if (batch.first == std::string_view::npos) {
+                    state.parse->feed(batch.src).finish();
+                } else {
+                    // Elements are parsed as an array of their own that starts at the right index for exact labels,
+                    // the space ends the bracket's token so the array exists before its offset is set
+                    state.parse->feed("[ ");
+                    state.parse->path.skip_elements(batch.first);
+                    state.parse->feed(batch.src).feed("]").finish();
+                }
+            } catch (...) {
+                batch.error = std::current_exception();
+                state.parse.reset(); // Whatever state it was left in is useless
+            }
+        }
+        {
+            std::lock_guard guard(done_lock);
+            batch.done = true;
+            running--;
+            if (!in_order) finished.push_back(&batch);
+        }
+        done_wake.notify_all();
+    }
+    void ParallelParse::deliver(Batch& batch) {
+        size_t e = 0;
+        for (size_t d = 0; d <= batch.documents.size(); d++) {
+            while (e < batch.errors.size() && batch.errors[e].first == d) on_error(batch.errors[e++].second);
+            if (d == batch.documents.size()) break;
+            auto& document = batch.documents[d];
+            path.reset();
+            path.replay(document);
+            path.pop(document);
+            if (on_document) on_document(document);
+        }
+        if (batch.error) std::rethrow_exception(batch.error);
+    }
+    // Elements come out of the range's own array in order, the path carries on where the last range stopped
+    void ParallelParse::splice(Batch& batch, JSArray& array) {
+        if (batch.error) std::rethrow_exception(batch.error);
+        for (auto& element : batch.documents.front().array()) {
+            path.push_element();
+            path.replay(element);
+            if (!path.pop(element)) array.push_back(std::move(element));
+        }
+    }
+    void ParallelParse::drain() {
+        std::unique_lock guard(done_lock);
+        done_wake.wait(guard, [this]() { return running == 0; });
+        finished.clear();
+    }
+
+    void ParallelParse::run_batches(Cutter&& cut, Deliverer&& deliver, bool ordered) {
+        const size_t window = std::max<size_t>(1, parallel.window ? parallel.window : pool.size() * 4);
+        in_order = ordered;
+        std::vector<Batch> slots(window);
+        size_t submitted = 0;
+        size_t delivered = 0;
+        // Batches go into the slot that was just delivered, in order that's always the next one round the ring
+        const auto submit = [&](Batch& batch) {
+            batch.first = std::string_view::npos;
+            if (!cut(batch)) return;
+            batch.documents.clear(); // Capacity stays
+            batch.errors.clear();
+            batch.error = nullptr;
+            batch.done = false;
+            submitted++;
+            {
+                std::lock_guard guard(done_lock);
+                running++;
+            }
+            pool.submit([this, &batch](size_t worker) { run(batch, worker); });
+        };
+        try {
+            for (auto& batch : slots) submit(batch);
+            while (delivered < submitted) {
+                Batch* batch;
+                {
+                    std::unique_lock guard(done_lock);
+                    if (in_order) {
+                        batch = &slots[delivered % window];
+                        done_wake.wait(guard, [batch]() { return batch->done; });
+                    } else {
+                        done_wake.wait(guard, [this]() { return !finished.empty(); });
+                        batch = finished.front();
+                        finished.pop_front();
+                    }
+                }
+                deliver(*batch);
+                delivered++;
+                submit(*batch);
+            }
+            drain();
+        } catch (...) {
+            // Batches still running point into the slots and the source
+            cancelled = true;
+            drain();
+            cancelled = false;
+            throw;
+        }
+    }
+
+    void ParallelParse::parse(std::string_view src) {
+        size_t cut = 0;
+        run_batches(
+            [&](Batch& batch) {
+                if (cut == src.size()) return false;
+                const auto end = src.find('\n', std::min(cut + parallel.batch_size, src.size()));
+                const auto next = end == std::string_view::npos ? src.size() : end + 1;
+                batch.src = src.substr(cut, next - cut);
+                cut = next;
+                return true;
+            },
+            [this](Batch& batch) { deliver(batch); }, parallel.ordered);
+    }
+
+    JSValue ParallelParse::string(std::string_view src) {
+        size_t pos = 0;
+        while (pos < src.size() && is_whitespace(src[pos])) pos++;
+        path.reset();
+        // Only arrays can be split
+        if (pos == src.size() || src[pos] != '[') {
+            auto single = options;
+            single.multi_document = false;
+            Parse json(single);
+            for (const auto& label : kept) json.keep(label);
+            json.feed(src).finish();
+            path.replay(json.value);
+            path.pop(json.value);
+            return std::move(json.value);
+        }
+        pos++;
+
+        JSValue value = JSArray();
+        auto& array = value.array();
+        size_t elements = 0;
+        bool ended = false;
+        // Element boundaries are found with a skipper over a window of the source, indexed a window at a time
+        Skipper skipper;
+        StructuralIndex index;
+        std::string_view window;
+        size_t base = 0;
+        const auto skip_element = [&]() {
+            skipper.start();
+            while (true) {
+                if (pos < base || pos >= base + window.size()) {
+                    base = pos;
+                    window = src.substr(base, std::max<size_t>(parallel.batch_size, 4096));
+                    if (window.size() >= simd_threshold)
+                        index.build(window);
+                    else
+                        index.clear();
+                }
+                size_t i = pos - base;
+                const bool done = skipper.skip(window, i, index);
+                pos = base + i;
+                if (done) return;
+                if (pos == src.size()) {
+                    if (!skipper.can_end()) throw sjson_parse_error::unexpected_eof();
+                    return;
+                }
+            }
+        };
+        // Commas between elements are auto-corrected like Parse does, false at the closing bracket
+        const auto separators = [&]() {
+            for (; pos < src.size(); pos++) {
+                const char c = src[pos];
+                if (is_whitespace(c) || c == ',') continue;
+                if (c == ']') return false;
+                if (is_operator(c) && c != '[' && c != '{') throw sjson_parse_error::unexpected_token(src.substr(pos, 1));
+                return true;
+            }
+            throw sjson_parse_error::unexpected_eof();
+        };
+        run_batches(
+            [&](Batch& batch) {
+                if (ended) return false;
+                if (!separators()) {
+                    ended = true;
+                    for (pos++; pos < src.size(); pos++) {
+                        if (!is_whitespace(src[pos])) throw sjson_parse_error::unexpected_data();
+                    }
+                    return false;
+                }
+                const auto start = pos;
+                batch.first = elements;
+                do {
+                    skip_element();
+                    elements++;
+                } while (pos - start < parallel.batch_size && separators());
+                batch.src = src.substr(start, pos - start);
+                return true;
+            },
+            [&](Batch& batch) { splice(batch, array); }, true);
+        path.pop(value);
+        return value;
+    }
+} // namespace SJSON
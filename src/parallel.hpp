@@ -0,0 +1,83 @@
+#pragma once
+#include "listener.hpp"
+#include "options.hpp"
+#include "pool.hpp"
+#include "value.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace SJSON {
+    class Parse;
+
+    struct ParallelOptions {
+        size_t threads = 0;          // One per core if 0
+        size_t batch_size = 1 << 20; // Bytes per batch, each one is cut at the first newline (or array element) after this
+        bool ordered = true;         // Deliver documents in input order, otherwise as soon as their batch is done (arrays are always in order)
+        size_t window = 0;           // Batches parsed ahead of delivery, bounds memory either way (4 per thread if 0)
+    };
+
+    /*
+        Parses newline-delimited documents or the elements of one huge array on a work-stealing pool,
+        each thread keeps one multi-document Parse and everything is delivered on the calling thread
+        Listeners are called on the calling thread too, over the values the threads built
+    */
+    class ParallelParse {
+    protected:
+        struct Batch {
+            std::string_view src;
+            size_t first = std::string_view::npos; // Index of the first element if it's a range of an array
+            std::vector<JSValue> documents;
+            std::vector<std::pair<size_t, sjson_parse_error>> errors; // Resynced ones, with how many documents came before them
+            std::exception_ptr error;                                 // Stops the whole parse
+            bool done = false;
+        };
+        typedef std::move_only_function<bool(Batch&)> Cutter; // Fills in the next batch, false once there's none
+        typedef std::move_only_function<void(Batch&)> Deliverer;
+        struct Worker {
+            std::unique_ptr<Parse> parse;
+            Batch* batch = nullptr;
+        };
+        ParseOptions options;
+        ParallelOptions parallel;
+        JSONCallback on_document;
+        JSONErrorCallback on_error;
+        JSPath path;
+        std::vector<std::string> kept; // Labels the threads have to build when projecting
+        std::vector<Worker> workers;   // Only ever touched by their own thread
+        std::mutex done_lock;
+        std::condition_variable done_wake;
+        std::deque<Batch*> finished; // Completion order when unordered
+        size_t running = 0;
+        bool in_order = true;
+        std::atomic<bool> cancelled = false;
+        WorkPool pool; // Last so its threads are joined before anything they use goes away
+
+        void run(Batch& batch, size_t worker);
+        void deliver(Batch& batch);
+        void splice(Batch& batch, JSArray& array);
+        void drain(); // Waits for every running batch
+        void run_batches(Cutter&& cut, Deliverer&& deliver, bool ordered);
+
+    public:
+        ParallelParse(ParseOptions options = {}, ParallelOptions parallel = {});
+        ParallelParse(const ParallelParse&) = delete;
+        ParallelParse& operator=(const ParallelParse&) = delete;
+        ~ParallelParse();
+
+        ParallelParse& documents(JSONCallback&& cb);
+        ParallelParse& resync(JSONErrorCallback&& cb); // Same as Parse::resync() but called on the calling thread, only for documents
+        ParallelParse& listen(std::string label, JSONCallback&& cb);
+        ParallelParse& keep(std::string label);
+        void parse(std::string_view src); // Returns once every document was delivered, src only has to live until then
+        JSValue string(std::string_view src); // One document, its elements are parsed in parallel if it's an array
+    };
+} // namespace SJSON
@@ -0,0 +1,65 @@
+#include "pool.hpp"
+#include <algorithm>
+
+namespace SJSON {
+    WorkPool::WorkPool(size_t threads) {
+        if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+        // Only started once every queue exists cuz they steal from each other
+        for (size_t i = 0; i < threads; i++) this->threads.emplace_back([this, i]() { work(i); });
+    }
+    WorkPool::~WorkPool() {
+        {
+            std::lock_guard guard(idle_lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        threads.clear(); // Joins
+    }
+    size_t WorkPool::size() const noexcept {
+        return queues.size();
+    }
+    // Counted before it's queued so the count never goes below what's actually there
+    void WorkPool::submit(PoolTask task) {
+        {
+            std::lock_guard guard(idle_lock);
+            pending++;
+        }
+        {
+            auto& queue = *queues[next++ % queues.size()];
+            std::lock_guard guard(queue.lock);
+            queue.tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+    bool WorkPool::take(size_t worker, PoolTask& task) {
+        for (size_t i = 0; i < queues.size(); i++) {
+            auto& queue = *queues[(worker + i) % queues.size()];
+            std::lock_guard guard(queue.lock);
+            if (queue.tasks.empty()) continue;
+            if (i == 0) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            } else {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            pending--;
+            return true;
+        }
+        return false;
+    }
+    void WorkPool::work(size_t worker) {
+        PoolTask task;
+        while (true) {
+            if (take(worker, task)) {
+                task(worker);
+                task = nullptr;
+                continue;
+            }
+            std::unique_lock guard(idle_lock);
+            wake.wait(guard, [this]() { return stopping || pending > 0; });
+            if (stopping && pending == 0) return;
+        }
+    }
+} // namespace SJSON
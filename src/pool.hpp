@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SJSON {
+    typedef std::move_only_function<void(size_t worker)> PoolTask; // Gets the index of the thread running it for per-thread state
+
+    /*
+        Fixed set of threads that each own a deque of tasks, submits are dealt out round-robin
+        Threads work their own deque from the front and steal from the back of the others once it's empty
+    */
+    class WorkPool {
+    protected:
+        struct Queue {
+            std::mutex lock;
+            std::deque<PoolTask> tasks;
+        };
+        std::vector<std::unique_ptr<Queue>> queues; // Pointers cuz mutexes can't move
+        std::vector<std::jthread> threads;
+        std::mutex idle_lock;
+        std::condition_variable wake;
+        std::atomic<size_t> pending = 0; // Submitted and not taken yet
+        size_t next = 0;
+        bool stopping = false;
+
+        bool take(size_t worker, PoolTask& task);
+        void work(size_t worker);
+
+    public:
+        explicit WorkPool(size_t threads = 0); // As many threads as there are cores if 0
+        WorkPool(const WorkPool&) = delete;
+        WorkPool& operator=(const WorkPool&) = delete;
+        ~WorkPool(); // Finishes every task that was submitted
+
+        size_t size() const noexcept;
+        void submit(PoolTask task); // Tasks can't throw, whatever they produce (errors included) is theirs to hand back
+    };
+} // namespace SJSON
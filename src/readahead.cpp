@@ -0,0 +1,70 @@
+#include "readahead.hpp"
+#include <algorithm>
+
+namespace SJSON {
+    ByteReader istream_reader(std::istream& in) {
+        return [&in](char* data, size_t size) -> size_t {
+            in.read(data, std::streamsize(size));
+            return size_t(in.gcount());
+        };
+    }
+
+    ReadAhead::ReadAhead(ByteReader&& reader, size_t buffers, size_t buffer_size):
+        sizes(std::max<size_t>(buffers, 1)),
+        buffer_size(std::max<size_t>(buffer_size, 1)),
+        reader(std::move(reader)) {
+        for (size_t i = 0; i < sizes.size(); i++) this->buffers.push_back(std::make_unique_for_overwrite<char[]>(this->buffer_size));
+        thread = std::thread([this]() { fill(); });
+    }
+    ReadAhead::ReadAhead(std::istream& in, size_t buffers, size_t buffer_size):
+        ReadAhead(istream_reader(in), buffers, buffer_size) {}
+    ReadAhead::~ReadAhead() {
+        stopping = true;
+        taken.fetch_add(1); // Wakes the reader if it's waiting for a buffer
+        taken.notify_one();
+        thread.join();
+    }
+
+    void ReadAhead::fill() {
+        const size_t count = buffers.size();
+        for (size_t i = 0;; i++) {
+            // Backpressure, every buffer is read and not given back yet
+            for (size_t t = taken.load(std::memory_order_acquire); i - t == count; t = taken.load(std::memory_order_acquire)) {
+                taken.wait(t, std::memory_order_acquire);
+                if (stopping) return;
+            }
+            if (stopping) return;
+            const size_t slot = i % count;
+            size_t size = 0;
+            try {
+                // Short reads are fine, only 0 ends the input
+                size = reader(buffers[slot].get(), buffer_size);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            sizes[slot] = size;
+            filled.store(i + 1, std::memory_order_release);
+            filled.notify_one();
+            if (!size) return;
+        }
+    }
+
+    std::string_view ReadAhead::next() {
+        if (ended) return std::string_view();
+        size_t t = taken.load(std::memory_order_relaxed);
+        if (holding) {
+            taken.store(++t, std::memory_order_release);
+            taken.notify_one();
+        }
+        for (size_t r = filled.load(std::memory_order_acquire); r == t; r = filled.load(std::memory_order_acquire))
+            filled.wait(r, std::memory_order_acquire);
+        holding = true;
+        const size_t slot = t % buffers.size();
+        if (!sizes[slot]) {
+            ended = true;
+            if (error) std::rethrow_exception(error);
+            return std::string_view();
+        }
+        return std::string_view(buffers[slot].get(), sizes[slot]);
+    }
+} // namespace SJSON
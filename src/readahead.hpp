@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace SJSON {
+    typedef std::move_only_function<size_t(char* data, size_t size)> ByteReader; // Fills in up to size bytes, 0 at the end of input
+    ByteReader istream_reader(std::istream& in); // The stream has to outlive it
+
+    /*
+        Reads on a thread of its own into a ring of fixed-size buffers so reading and parsing overlap
+        The ring is a single-producer/single-consumer queue of two counters, the reader waits once every buffer is full
+        and a buffer is only reused once the parser asked for the one after it
+    */
+    class ReadAhead {
+    protected:
+        std::vector<std::unique_ptr<char[]>> buffers;
+        std::vector<size_t> sizes;      // Bytes in each buffer, 0 marks the end of input
+        size_t buffer_size;
+        ByteReader reader;
+        std::exception_ptr error;       // Thrown by the reader, handed over with the end marker
+        std::atomic<size_t> filled = 0; // Buffers filled, only the reader writes it
+        std::atomic<size_t> taken = 0;  // Buffers given back, only the parser writes it
+        bool holding = false;           // The parser has the buffer at taken
+        bool ended = false;
+        std::atomic<bool> stopping = false;
+        std::thread thread; // Last so it's joined before anything it uses goes away
+
+        void fill();
+
+    public:
+        inline static constexpr size_t default_buffer_size = 1 << 20;
+
+        ReadAhead(ByteReader&& reader, size_t buffers = 4, size_t buffer_size = default_buffer_size);
+        explicit ReadAhead(std::istream& in, size_t buffers = 4, size_t buffer_size = default_buffer_size);
+        ReadAhead(const ReadAhead&) = delete;
+        ReadAhead& operator=(const ReadAhead&) = delete;
+        ~ReadAhead(); // Stops reading ahead, waits for a read that's already blocked though
+
+        std::string_view next(); // Blocks until the next buffer is read, empty at the end; the last view goes back to the reader
+    };
+} // namespace SJSON
@@ -0,0 +1,245 @@
+#include "simd.hpp"
+#include "syntax.hpp"
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define SJSON_X86_SIMD
+    #include <immintrin.h>
+#endif
+
+namespace SJSON {
+    namespace {
+        struct BlockMasks {
+            uint64_t strings;
+            uint64_t whitespace;
+        };
+        typedef BlockMasks (*BlockClassifier)(const char* block);
+
+        BlockMasks classify_scalar(const char* block) {
+            BlockMasks masks {0, 0};
+            for (size_t i = 0; i < simd_block; i++) {
+                const char c = block[i];
+                const uint64_t bit = uint64_t(1) << i;
+                const auto type = char_class(c);
+                if (type == CharClass::Quote || type == CharClass::Backslash) masks.strings |= bit;
+                if (type == CharClass::Whitespace) masks.whitespace |= bit;
+            }
+            return masks;
+        }
+
+#ifdef SJSON_X86_SIMD
+        // PCMPESTRM matches any character of a small set in one instruction
+        __attribute__((target("sse4.2"))) BlockMasks classify_sse42(const char* block) {
+            const __m128i string_set = _mm_setr_epi8(string_char, escape_char, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i whitespace_set = _mm_setr_epi8(' ', '\t', '\n', '\r', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            constexpr int mode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+            BlockMasks masks {0, 0};
+            for (size_t i = 0; i < simd_block; i += 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+                const uint64_t strings = static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cmpestrm(string_set, 2, v, 16, mode)));
+                const uint64_t whitespace = static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cmpestrm(whitespace_set, 4, v, 16, mode)));
+                masks.strings |= strings << i;
+                masks.whitespace |= whitespace << i;
+            }
+            return masks;
+        }
+        __attribute__((target("avx2"))) BlockMasks classify_avx2(const char* block) {
+            BlockMasks masks {0, 0};
+            for (size_t i = 0; i < simd_block; i += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+                const __m256i strings = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8(string_char)),
+                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8(escape_char)));
+                const __m256i whitespace = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+                masks.strings |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(strings))) << i;
+                masks.whitespace |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(whitespace))) << i;
+            }
+            return masks;
+        }
+#endif
+
+        // Everything the writer can't copy straight through, non-ASCII included cuz it has to be checked
+        constexpr auto needs_escape = []() {
+            std::array<bool, 256> table {};
+            for (size_t c = 0; c < 256; c++) table[c] = c < 0x20 || c >= 0x80 || escape_table[c];
+            return table;
+        }();
+        static_assert([]() {
+            for (size_t c = 0x20; c < 0x80; c++)
+                if (escape_table[c] && c != uint8_t(string_char) && c != uint8_t(escape_char) && c != '/') return false;
+            return true;
+        }(), "The vector scanners only look for these printable escapes");
+
+        size_t plain_run_scalar(const char* data, size_t size) {
+            size_t i = 0;
+            while (i < size && !needs_escape[uint8_t(data[i])]) i++;
+            return i;
+        }
+
+#ifdef SJSON_X86_SIMD
+        // The tail is padded with plain chars and run through the same vector code, calling SSE code with dirty AVX state is slow
+        __attribute__((target("sse2"))) uint32_t special_mask_sse2(const char* data) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i specials = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(string_char)), _mm_cmpeq_epi8(v, _mm_set1_epi8(escape_char))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f))));
+            // The sign bit is set for every non-ASCII byte
+            return uint32_t(_mm_movemask_epi8(specials) | _mm_movemask_epi8(v));
+        }
+        __attribute__((target("sse2"))) size_t plain_run_sse2(const char* data, size_t size) {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+                if (const auto mask = special_mask_sse2(data + i)) return i + std::countr_zero(mask);
+            char tail[16];
+            std::memset(tail, 'a', sizeof(tail));
+            std::memcpy(tail, data + i, size - i);
+            const auto mask = special_mask_sse2(tail);
+            return mask ? i + std::countr_zero(mask) : size;
+        }
+        __attribute__((target("avx2"))) uint32_t special_mask_avx2(const char* data) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            const __m256i specials = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(string_char)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(escape_char))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')), _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1f)), _mm256_set1_epi8(0x1f))));
+            return uint32_t(_mm256_movemask_epi8(specials)) | uint32_t(_mm256_movemask_epi8(v));
+        }
+        __attribute__((target("avx2"))) size_t plain_run_avx2(const char* data, size_t size) {
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32)
+                if (const auto mask = special_mask_avx2(data + i)) return i + std::countr_zero(mask);
+            char tail[32];
+            std::memset(tail, 'a', sizeof(tail));
+            std::memcpy(tail, data + i, size - i);
+            const auto mask = special_mask_avx2(tail);
+            return mask ? i + std::countr_zero(mask) : size;
+        }
+#endif
+
+        size_t ascii_run_scalar(const char* data, size_t size) {
+            size_t i = 0;
+            while (i < size && uint8_t(data[i]) < 0x80) i++;
+            return i;
+        }
+#ifdef SJSON_X86_SIMD
+        // Only the sign bits matter so whole blocks are or'd together before looking at them
+        __attribute__((target("sse2"))) size_t ascii_run_sse2(const char* data, size_t size) {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+                if (const auto mask = uint32_t(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)))))
+                    return i + std::countr_zero(mask);
+            return i + ascii_run_scalar(data + i, size - i);
+        }
+        __attribute__((target("avx2"))) size_t ascii_run_avx2(const char* data, size_t size) {
+            size_t i = 0;
+            for (; i + 64 <= size; i += 64) {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+                if (_mm256_movemask_epi8(_mm256_or_si256(a, b))) break;
+            }
+            for (; i + 32 <= size; i += 32)
+                if (const auto mask = uint32_t(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)))))
+                    return i + std::countr_zero(mask);
+            return i + ascii_run_scalar(data + i, size - i);
+        }
+#endif
+
+        struct StringScanners {
+            size_t (*plain_run)(const char* data, size_t size);
+            size_t (*ascii_run)(const char* data, size_t size);
+        };
+        const StringScanners& string_scanners() {
+            static const StringScanners picked = []() -> StringScanners {
+#ifdef SJSON_X86_SIMD
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) return {plain_run_avx2, ascii_run_avx2};
+                if (__builtin_cpu_supports("sse2")) return {plain_run_sse2, ascii_run_sse2};
+#endif
+                return {plain_run_scalar, ascii_run_scalar};
+            }();
+            return picked;
+        }
+
+        struct Classifier {
+            BlockClassifier classify;
+            const char* name;
+        };
+        // Picked once from what the running CPU supports
+        const Classifier& classifier() {
+            static const Classifier picked = []() -> Classifier {
+#ifdef SJSON_X86_SIMD
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2")) return {classify_avx2, "avx2"};
+                if (__builtin_cpu_supports("sse4.2")) return {classify_sse42, "sse4.2"};
+#endif
+                return {classify_scalar, "scalar"};
+            }();
+            return picked;
+        }
+    } // namespace
+
+    size_t StructuralIndex::next(const std::vector<uint64_t>& masks, size_t i, bool inverted) const noexcept {
+        for (size_t block = i / simd_block; block < masks.size(); block++) {
+            uint64_t mask = inverted ? ~masks[block] : masks[block];
+            if (block == i / simd_block) mask &= ~uint64_t(0) << (i % simd_block);
+            if (mask) {
+                const size_t found = block * simd_block + std::countr_zero(mask);
+                return found < length ? found : length;
+            }
+        }
+        return length;
+    }
+
+    void StructuralIndex::build(std::string_view chunk) {
+        const auto& picked = classifier();
+        const size_t blocks = (chunk.size() + simd_block - 1) / simd_block;
+        length = chunk.size();
+        strings.resize(blocks);
+        whitespace.resize(blocks);
+        size_t block = 0;
+        for (; (block + 1) * simd_block <= chunk.size(); block++) {
+            const auto masks = picked.classify(chunk.data() + block * simd_block);
+            strings[block] = masks.strings;
+            whitespace[block] = masks.whitespace;
+        }
+        // The tail is padded with bytes that don't belong to any class
+        if (block < blocks) {
+            char tail[simd_block] = {};
+            std::memcpy(tail, chunk.data() + block * simd_block, chunk.size() - block * simd_block);
+            const auto masks = picked.classify(tail);
+            strings[block] = masks.strings;
+            whitespace[block] = masks.whitespace;
+        }
+    }
+    void StructuralIndex::clear() noexcept {
+        strings.clear();
+        whitespace.clear();
+        length = 0;
+    }
+    bool StructuralIndex::empty() const noexcept {
+        return length == 0;
+    }
+    size_t StructuralIndex::next_string_char(size_t i) const noexcept {
+        return next(strings, i, false);
+    }
+    size_t StructuralIndex::next_non_whitespace(size_t i) const noexcept {
+        return next(whitespace, i, true);
+    }
+
+    const char* StructuralIndex::implementation() noexcept {
+        return classifier().name;
+    }
+
+    size_t plain_string_run(const char* data, size_t size) noexcept {
+        // Short strings aren't worth the indirect call
+        if (size < 16) return plain_run_scalar(data, size);
+        return string_scanners().plain_run(data, size);
+    }
+    size_t ascii_run(const char* data, size_t size) noexcept {
+        if (size < 16) return ascii_run_scalar(data, size);
+        return string_scanners().ascii_run(data, size);
+    }
+} // namespace SJSON
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace SJSON {
+    // Chunks smaller than this aren't worth indexing
+    inline constexpr size_t simd_threshold = 64;
+    inline constexpr size_t simd_block = 64;
+
+    /*
+        Stage-1 pass over a chunk that marks which bytes the lexer can't skip
+        Every 64 byte block gets a bitmask per character class so the lexer can jump
+        straight through string contents and whitespace instead of classifying every byte
+    */
+    class StructuralIndex {
+    protected:
+        std::vector<uint64_t> strings;    // Quotes and backslashes
+        std::vector<uint64_t> whitespace; // Whitespace outside of tokens
+        size_t length = 0;
+
+        size_t next(const std::vector<uint64_t>& masks, size_t i, bool inverted) const noexcept;
+
+    public:
+        StructuralIndex() = default;
+        ~StructuralIndex() = default;
+
+        void build(std::string_view chunk);
+        void clear() noexcept;
+        bool empty() const noexcept;
+        // These return the length of the chunk if no such character is left
+        size_t next_string_char(size_t i) const noexcept;
+        size_t next_non_whitespace(size_t i) const noexcept;
+
+        // Name of the block classifier picked at runtime
+        static const char* implementation() noexcept;
+    };
+
+    // Length of the run at the start of data that can be written into a JSON string as is (printable ASCII without escapes)
+    size_t plain_string_run(const char* data, size_t size) noexcept;
+    // Length of the run of ASCII at the start of data
+    size_t ascii_run(const char* data, size_t size) noexcept;
+} // namespace SJSON
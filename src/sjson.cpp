@@ -2,224 +2,285 @@
 #include "listener.hpp"
 #include "syntax.hpp"
 #include "value.hpp"
+#include <algorithm>
 #include <initializer_list>
+#include <memory>
+#include <stdexcept>
 #include <string>
 
 namespace SJSON {
-    // End of file if stream returns an empty string
-    bool Parse::is_eof() const noexcept {
-        return chunk.size() == 0;
-    }
     // If there are no more references, no more values are expected
     bool Parse::is_finished() const noexcept {
         return references.empty();
     }
-    bool Parse::readable() const noexcept {
-        return i < chunk.size();
+    // Nothing of the next document has been read
+    bool Parse::is_fresh() const noexcept {
+        return references.size() == 1 && references.top() == &value && value.is_null();
     }
     bool Parse::prev_is_type(JSValueType type) const {
         if (!references.has_prev()) return false;
         return references.prev()->type() == type;
     }
-    // Reset read state
-    void Parse::use_chunk(std::string src) {
-        if (readable()) throw sjson_internal_parse_error::new_chunk_before_finish();
-        i = 0;
-        chunk = std::move(src);
+    Context Parse::context() const {
+        switch (references.top()->type()) {
+            case JSValueType::Null: return Context::Value; // If value needs to be determined
+            case JSValueType::Object: return Context::Object;
+            case JSValueType::Array: return Context::Array;
+            // This shouldn't happen because literals are automatically escaped
+            default: throw sjson_internal_parse_error::invalid_reference_state();
+        }
+    }
+    JSKey Parse::make_key(std::string_view key) {
+        if (!options.intern_keys) return JSKey(key, options.memory());
+        return options.keys ? options.keys->intern(key) : keys.intern(key);
     }
-    // Copy and reset for a new streamed token
-    Token Parse::mk_token() {
-        Token token = current_token.copy();
+    // Stacks keep their capacity, the last document is only replaced once the next one starts
+    void Parse::next_document() {
+        references.clear();
+        references.push(&value);
+        path.reset();
+        value = JSValue();
         current_token.reset();
-        return token;
-    }
-    Token Parse::read_token() {
-        if (readable()) {
-            while (readable()) {
-                auto c = chunk[i];
-                if (current_token.is_terminating(c))
-                    return mk_token();
-                current_token.push(c);
-                i++;
+        skipping = false;
+    }
+    // Parses what's left of the current chunk
+    void Parse::parse_chunk() {
+        if (options.format == Format::CBOR) { // Binary has no lines to resync at
+            const auto src = chunk.substr(i);
+            i = chunk.size();
+            return decoder.decode(*this, src, is_eof());
+        }
+        while (true) {
+            try {
+                return parse_tokens();
+            } catch (const sjson_parse_error& err) {
+                if (!on_error || !options.multi_document) throw;
+                on_error(err);
+                resyncing = true;
             }
-        } else if (is_eof()) {
-            // No argument represents eof (errors still work cuz tokens check validity when their value is accessed)
-            if (current_token.is_terminating())
-                return mk_token();
         }
-        // If the current token is unfinished
-        return Token();
     }
-    void Parse::parse_chunk(std::string src) {
-        use_chunk(std::move(src));
+    void Parse::parse_tokens() {
         while (true) {
+            if (resyncing) {
+                // The broken document goes up to the next newline, it might straddle chunks too
+                const auto end = chunk.find('\n', i);
+                i = end == std::string_view::npos ? chunk.size() : end + 1;
+                if (end == std::string_view::npos && !is_eof()) break;
+                resyncing = false;
+                next_document();
+                continue;
+            }
+            if (skipping) {
+                if (!skipper.skip(chunk, i, index)) {
+                    if (!is_eof()) break; // The rest of the value comes with the next chunk
+                    if (!skipper.can_end()) throw sjson_parse_error::unexpected_eof();
+                }
+                skipping = false;
+                end_skipped();
+                continue;
+            }
             auto token = read_token();
             if (token.is_unresolved()) {
-                if (is_eof() && !is_finished())
+                if (is_eof() && !is_finished() && !(options.multi_document && is_fresh()))
                     throw sjson_parse_error::unexpected_eof();
                 break;
             };
-            if (is_finished())
-                throw sjson_parse_error::unexpected_data();
-            switch (references.top()->type()) {
-                // This shouldn't happen because literals are automatically escaped
-                case JSValueType::Number:
-                case JSValueType::Boolean:
-                case JSValueType::String:
-                    throw sjson_internal_parse_error::invalid_reference_state();
-                // If value needs to be determined
-                case JSValueType::Null: {
-                    switch (token.type) {
-                        case TokenType::Unresolved: break;
-                        case TokenType::Operator: {
-                            switch (token.to_operator()) {
-                                case Operators::Colon:
-                                    // Colons are only valid in object contexts
-                                    if (!prev_is_type(JSValueType::Object))
-                                        throw sjson_parse_error::unexpected_token(token.src);
-                                    break;
-                                case Operators::Comma:
-                                case Operators::ArrayEnd:
-                                case Operators::ObjectEnd:
-                                    throw sjson_parse_error::unexpected_token(token.src);
-                                case Operators::ArrayStart:
-                                    *references.top() = JSValue(JSArray());
-                                    break;
-                                case Operators::ObjectStart:
-                                    *references.top() = JSValue(JSObject());
-                                    break;
-                            }
-                            break;
-                        }
-                        case TokenType::Keyword:
-                        case TokenType::Number:
-                        case TokenType::String: {
-                            *references.top() = token.to_value();
-                            path.pop(*references.top());
-                            references.pop();
-                            break;
-                        }
-                    }
-                    break;
-                }
-                case JSValueType::Object: {
-                    switch (token.type) {
-                        case TokenType::Unresolved: break;
-                        case TokenType::Operator: {
-                            switch (token.to_operator()) {
-                                case Operators::Colon:
-                                case Operators::ArrayEnd:
-                                case Operators::ArrayStart:
-                                case Operators::ObjectStart:
-                                    throw sjson_parse_error::unexpected_token(token.src);
-                                case Operators::Comma:
-                                    break; // Commas are ignored cuz objects follow a specific pattern anyways
-                                case Operators::ObjectEnd: {
-                                    // Handle a generic drop for arrays
-                                    if (path.pop(*references.top()) && prev_is_type(JSValueType::Array))
-                                        references.prev()->array().pop_back();
-                                    references.pop();
-                                    break;
-                                }
-                            }
-                            break;
-                        }
-                        case TokenType::Keyword:
-                        case TokenType::Number:
-                            throw sjson_parse_error::unexpected_token(token.src);
-                        case TokenType::String: {
-                            const auto key = token.to_string();
-                            auto& root = references.top()->object();
-                            root[key] = JSValue();
-                            references.push(&root[key]);
-                            path.push(key);
-                            break;
-                        }
+            open_document();
+            switch (grammar_step(context(), token, prev_is_type(JSValueType::Object))) {
+                case Step::Skip: break;
+                case Step::Colon: {
+                    if (references.top() == &skipped) {
+                        skipper.start();
+                        skipping = true;
                     }
                     break;
                 }
-                case JSValueType::Array: {
-                    switch (token.type) {
-                        case TokenType::Unresolved: break;
-                        case TokenType::Operator: {
-                            const auto op = token.to_operator();
-                            switch (op) {
-                                case Operators::Colon:
-                                case Operators::ObjectEnd:
-                                    throw sjson_parse_error::unexpected_token(token.src);
-                                case Operators::Comma:
-                                    break; // Commas are ignored cuz the parser handles values individually
-                                case Operators::ArrayEnd: {
-                                    // Handle a generic drop for arrays
-                                    if (path.pop(*references.top()) && prev_is_type(JSValueType::Array))
-                                        references.prev()->array().pop_back();
-                                    references.pop();
-                                    break;
-                                }
-                                case Operators::ArrayStart:
-                                case Operators::ObjectStart: {
-                                    auto& root = references.top()->array();
-                                    if (op == Operators::ArrayStart)
-                                        root.push_back(JSArray());
-                                    else
-                                        root.push_back(JSObject());
-                                    references.push(&root.back());
-                                    path.push(root.size() - 1);
-                                    break;
-                                }
-                            }
-                            break;
-                        }
-                        case TokenType::Keyword:
-                        case TokenType::Number:
-                        case TokenType::String: {
-                            const auto value = token.to_value();
-                            auto& root = references.top()->array();
-                            path.push(root.size());
-                            if (!path.pop(value)) root.push_back(value); // Only push if needed
-                            break;
-                        }
+                case Step::Key: begin_member(token.string_body(options.validate_utf8)); break;
+                case Step::Scalar: put_scalar([&] { return token.to_value(options); }); break;
+                case Step::StartObject:
+                case Step::StartArray: {
+                    if (!begin_container(token.to_operator() == Operators::ArrayStart)) {
+                        skipper.start(1);
+                        skipping = true;
                     }
                     break;
                 }
+                case Step::EndObject:
+                case Step::EndArray: end_container(); break;
             }
+            close_document();
+        }
+    }
+
+    void Parse::open_document() {
+        if (!is_finished()) return;
+        if (!options.multi_document) throw sjson_parse_error::unexpected_data();
+        next_document();
+    }
+    void Parse::close_document() {
+        if (on_document && is_finished()) on_document(value);
+    }
+    void Parse::begin_member(std::string_view key_src) {
+        auto key = make_key(key_src);
+        path.push(key.share());
+        // Members that aren't wanted are never inserted, their value gets skipped
+        auto& member = path.wanted() ? references.top()->object()[std::move(key)] : skipped;
+        member = JSValue();
+        references.push(&member);
+    }
+    bool Parse::begin_container(bool is_array) {
+        if (references.top() == &skipped) return false; // A member that isn't wanted
+        if (context() == Context::Value) {
+            if (is_array)
+                *references.top() = JSValue(JSArray(options.memory()));
+            else
+                *references.top() = JSValue(JSObject(options.objects, options.memory()));
+            return true;
+        }
+        path.push_element();
+        if (!path.wanted()) {
+            references.push(&skipped);
+            return false;
         }
+        auto& root = references.top()->array();
+        if (is_array)
+            root.push_back(JSArray(options.memory()));
+        else
+            root.push_back(JSObject(options.objects, options.memory()));
+        references.push(&root.back());
+        return true;
+    }
+    void Parse::end_container() {
+        // Handle a generic drop for arrays
+        if (path.pop(*references.top()) && prev_is_type(JSValueType::Array))
+            references.prev()->array().pop_back();
+        references.pop();
+    }
+    void Parse::end_skipped() {
+        references.pop();
+        path.pop();
     }
 
     Parse::Parse(JSONStream&& src, bool drop_generics):
-        istream(std::move(src)),
+        Parse(std::move(src), ParseOptions {.drop_generics = drop_generics}) {}
+    Parse::Parse(JSONStream&& src, ParseOptions options):
+        Lexer(std::move(src)),
+        options(options),
         references({&value}),
-        path(drop_generics) {}
-    Parse::Parse(std::string src):
-        istream([]() -> std::string {
+        path(options.drop_generics, options.project, options.intern_keys ? (options.keys ? options.keys : &keys) : nullptr) {
+        indexing = options.format == Format::JSON;
+    }
+    Parse::Parse(std::string src, ParseOptions options):
+        Lexer([]() -> std::string {
             return ""; // Predefined parse, no stream needed
         }),
+        options(options),
         references({&value}),
-        path(false) {
-        parse_chunk(std::move(src));
-        parse_chunk(""); // Simulate end of stream
+        path(options.drop_generics, options.project, options.intern_keys ? (options.keys ? options.keys : &keys) : nullptr) {
+        indexing = options.format == Format::JSON;
+        use_chunk(std::move(src));
+        parse_chunk();
+        finish(); // Simulate end of stream
+    }
+    Parse::Parse(ParseOptions options):
+        Parse(JSONStream(), options) {
+        pushed = true;
     }
 
     // Data parsing
-    JSValue Parse::string(std::string src) {
-        return Parse(std::move(src)).value;
+    JSValue Parse::string(std::string src, ParseOptions options) {
+        return Parse(std::move(src), options).value;
     }
-    JSValue Parse::stream(JSONStream&& src) {
-        Parse json(std::move(src));
+    JSValue Parse::stream(JSONStream&& src, ParseOptions options) {
+        Parse json(std::move(src), options);
         json.all();
-        return json.value;
+        return std::move(json.value);
+    }
+    JSValue Parse::file(const std::string& path, ParseOptions options) {
+        MappedFile mapped(path);
+        Parse json(options);
+        json.feed(mapped).finish();
+        return std::move(json.value);
+    }
+    JSValue Parse::cbor(std::string_view src, ParseOptions options) {
+        options.format = Format::CBOR;
+        Parse json(options);
+        json.feed(src).finish();
+        return std::move(json.value);
     }
     Parse& Parse::listen(std::string label, JSONCallback&& cb) {
         path.listen(std::move(label), std::move(cb));
         return *this;
     }
+    Parse& Parse::keep(std::string label) {
+        path.keep(label);
+        return *this;
+    }
     bool Parse::next() {
-        parse_chunk(istream()); // Parse stream even if eof
+        if (pushed) throw std::logic_error("Parse::next(): push parses are fed, not streamed");
+        use_chunk(istream());
+        parse_chunk(); // Parse stream even if eof
         return !is_eof();
     }
     void Parse::all() {
         while (next());
     }
+    Parse& Parse::feed(std::string_view data) {
+        if (data.empty()) return *this; // Would look like the end of input
+        use_chunk(data);
+        parse_chunk();
+        return *this;
+    }
+    // Feeding never keeps a view of the data, so pages behind the window are done with
+    Parse& Parse::feed(MappedFile& file, size_t window) {
+        const auto src = file.view();
+        window = std::max<size_t>(window, 1);
+        for (size_t pos = 0; pos < src.size(); pos += window) {
+            feed(src.substr(pos, window));
+            file.release(pos + window);
+        }
+        return *this;
+    }
+    // Buffers are borrowed, each one goes back to the reader once the next one's asked for
+    Parse& Parse::feed(ReadAhead& input) {
+        for (auto data = input.next(); !data.empty(); data = input.next()) feed(data);
+        return *this;
+    }
+    Parse& Parse::feed(ByteReader&& reader, size_t buffer_size) {
+        buffer_size = std::max<size_t>(buffer_size, 1);
+        const auto buffer = std::make_unique_for_overwrite<char[]>(buffer_size);
+        for (size_t size; (size = reader(buffer.get(), buffer_size));) feed(std::string_view(buffer.get(), size));
+        return *this;
+    }
+    void Parse::finish() {
+        use_chunk(std::string_view());
+        parse_chunk();
+    }
+    Parse& Parse::collect(std::string label) {
+        return listen(std::move(label), [this](const JSValue& value) {
+            collected.push_back(value);
+        });
+    }
+    Parse& Parse::documents(JSONCallback&& cb) {
+        on_document = std::move(cb);
+        return *this;
+    }
+    Parse& Parse::resync(JSONErrorCallback&& cb) {
+        on_error = std::move(cb);
+        return *this;
+    }
+    Generator<JSValue> Parse::values() {
+        for (bool more = !pushed;; more = next()) {
+            while (!collected.empty()) {
+                auto value = std::move(collected.front());
+                collected.pop_front();
+                co_yield std::move(value);
+            }
+            // Streams are only read as far as the next value needs
+            if (!more) break;
+        }
+    }
 
     // Data access
     std::string Parse::to_string(int index_length) const {
@@ -1,50 +1,120 @@
 #pragma once
+#include "cache.hpp"
+#include "cbor.hpp"
+#include "cursor.hpp"
+#include "events.hpp"
+#include "file.hpp"
+#include "generator.hpp"
+#include "gzip.hpp"
+#include "key.hpp"
+#include "lexer.hpp"
 #include "listener.hpp"
+#include "options.hpp"
+#include "parallel.hpp"
+#include "pool.hpp"
+#include "readahead.hpp"
+#include "simd.hpp"
+#include "skip.hpp"
+#include "tape.hpp"
 #include "token.hpp"
 #include "util.hpp"
 #include "value.hpp"
+#include "writer.hpp"
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace SJSON {
-    typedef std::move_only_function<std::string()> JSONStream;
-
-    class Parse {
+    class Parse : protected Lexer {
     protected:
-        JSONStream istream;
+        friend class ParallelParse;
+        friend class CBORDecoder;
+        ParseOptions options;
         VectorStack<JSValue*> references;
         JSPath path;
-        Token current_token;
-        size_t i;
-        std::string chunk;
+        KeyTable keys;
+        Skipper skipper;
+        bool skipping = false;
+        JSValue skipped; // Stands in for values that are skipped
+        bool pushed = false; // Input is fed instead of pulled from the stream
+        std::deque<JSValue> collected;
+        JSONCallback on_document;   // Not a root listener so projecting still skips what isn't wanted
+        JSONErrorCallback on_error; // Resyncs multiple documents instead of throwing if set
+        bool resyncing = false;     // Skipping the rest of a malformed line
+        CBORDecoder decoder; // Only used with Format::CBOR
 
-        bool is_eof() const noexcept;
         bool is_finished() const noexcept;
-        bool readable() const noexcept;
+        bool is_fresh() const noexcept;
         bool prev_is_type(JSValueType type) const;
-        void use_chunk(std::string src);
-        Token mk_token();
-        Token read_token();
-        void parse_chunk(std::string src);
+        Context context() const;
+        JSKey make_key(std::string_view key);
+        void parse_chunk();
+        void parse_tokens();
+        void next_document();
+
+        /*
+            Building blocks every input format drives the value, path and projection with
+            A value that's skipped keeps skipped on top of the references until end_skipped()
+        */
+        void open_document(); // Before anything of a value, starts the next document if the last one is done
+        void close_document(); // After a value, hands out the document if that finished it
+        void begin_member(std::string_view key);
+        bool begin_container(bool is_array); // False if nobody wants it, then it has to be skipped
+        void end_container();
+        void end_skipped();
+        // make is only called if something wants the scalar
+        template <typename Make>
+        void put_scalar(Make&& make) {
+            if (references.top() == &skipped) return end_skipped();
+            if (context() == Context::Value) {
+                *references.top() = make();
+                path.pop(*references.top());
+                references.pop();
+                return;
+            }
+            path.push_element();
+            if (!path.wanted()) {
+                path.pop();
+                return;
+            }
+            auto value = make();
+            if (!path.pop(value)) references.top()->array().push_back(std::move(value)); // Only push if needed
+        }
 
     public:
         JSValue value;
 
         Parse(JSONStream&& src, bool drop_generics = false);
-        Parse(std::string src);
+        Parse(JSONStream&& src, ParseOptions options);
+        Parse(std::string src, ParseOptions options = {});
+        explicit Parse(ParseOptions options = {}); // Push parse, input comes from feed()
         Parse(const Parse&) = delete;
         Parse& operator=(const Parse&) = delete;
-        Parse(Parse&&) noexcept = default;
-        Parse& operator=(Parse&&) noexcept = default;
+        // Pinned, references point into value and collect() listens through this
+        Parse(Parse&&) = delete;
+        Parse& operator=(Parse&&) = delete;
         ~Parse() = default;
 
         // Data parsing
-        static JSValue string(std::string src);
-        static JSValue stream(JSONStream&& src);
+        static JSValue string(std::string src, ParseOptions options = {});
+        static JSValue stream(JSONStream&& src, ParseOptions options = {});
+        static JSValue file(const std::string& path, ParseOptions options = {}); // Mapped instead of read, see MappedFile
+        static JSValue cbor(std::string_view src, ParseOptions options = {}); // Same as Format::CBOR, src only has to live until it returns
         Parse& listen(std::string label, JSONCallback&& cb);
+        Parse& keep(std::string label); // Builds a path when projecting without listening to it
         bool next();
         void all();
+        Parse& feed(std::string_view data); // Parses whatever's there and returns, the data only has to live until then
+        Parse& feed(MappedFile& file, size_t window = MappedFile::window); // Feeds the mapping a window at a time and releases what's parsed
+        Parse& feed(ReadAhead& input); // Feeds every buffer until the end of input, parsing overlaps the next reads
+        Parse& feed(ByteReader&& reader, size_t buffer_size = 1 << 16); // Reads into one buffer and feeds it until the end of input
+        void finish(); // End of input for a push parse
+        Parse& collect(std::string label); // Listens by queueing copies of the values for values()
+        Generator<JSValue> values(); // Collected values as they're completed, pushed parses stop once the queue is empty
+        Parse& documents(JSONCallback&& cb); // Called with every root value once it's done, see ParseOptions::multi_document
+        Parse& resync(JSONErrorCallback&& cb); // Malformed documents are skipped up to the next newline and handed to cb instead of throwing
 
         // Data access
         std::string to_string(int index_length = 0) const;
@@ -0,0 +1,80 @@
+#include "skip.hpp"
+#include "syntax.hpp"
+
+namespace SJSON {
+    void Skipper::start(size_t depth) noexcept {
+        this->depth = depth;
+        in_string = false;
+        escaped = false;
+        scalar = false;
+    }
+    bool Skipper::skip(std::string_view chunk, size_t& i, const StructuralIndex& index) {
+        while (i < chunk.size()) {
+            const char c = chunk[i];
+            if (in_string) {
+                if (escaped) {
+                    escaped = false;
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '"') {
+                    in_string = false;
+                    if (!depth) {
+                        i++;
+                        return true;
+                    }
+                } else if (!index.empty()) {
+                    i = index.next_string_char(i); // Jump straight to the next quote or backslash
+                    continue;
+                }
+                i++;
+                continue;
+            }
+            switch (c) {
+                case '"':
+                    if (scalar) return true;
+                    in_string = true;
+                    break;
+                case '[':
+                case '{':
+                    if (scalar) return true;
+                    depth++;
+                    break;
+                case ']':
+                case '}':
+                    if (!depth) {
+                        // Closes the parent, the value already ended if it ever started
+                        if (!scalar) throw sjson_parse_error::unexpected_token(chunk.substr(i, 1));
+                        return true;
+                    }
+                    if (!--depth) {
+                        i++;
+                        return true;
+                    }
+                    break;
+                case ',':
+                    if (!depth) {
+                        if (!scalar) throw sjson_parse_error::unexpected_token(chunk.substr(i, 1));
+                        return true;
+                    }
+                    break;
+                case ':':
+                    if (depth) break;
+                    if (scalar) throw sjson_parse_error::unexpected_token(chunk.substr(i, 1));
+                    break; // Doubled colons before the value are auto-corrected like Parse does
+                default:
+                    if (depth) break;
+                    if (is_whitespace(c)) {
+                        if (scalar) return true;
+                    } else {
+                        scalar = true;
+                    }
+                    break;
+            }
+            i++;
+        }
+        return false;
+    }
+    bool Skipper::can_end() const noexcept {
+        return !in_string && !depth;
+    }
+} // namespace SJSON
@@ -0,0 +1,31 @@
+#pragma once
+#include "simd.hpp"
+#include <cstddef>
+#include <string_view>
+
+namespace SJSON {
+    /*
+        Scans past a value without building it, for subtrees nobody asked for
+        Only strings and brackets are tracked so anything inside a skipped value isn't validated,
+        and the scan picks up where it left off when the value straddles chunks
+    */
+    class Skipper {
+    protected:
+        size_t depth = 0;
+        bool in_string = false;
+        bool escaped = false;
+        bool scalar = false;
+
+    public:
+        Skipper() = default;
+        ~Skipper() = default;
+
+        void start(size_t depth = 0) noexcept; // Depth 1 when the opening bracket was already read
+        // True once the value ended, i is left on the first byte after it
+        // Throws if the value is missing or a scalar runs into a colon, nothing else is checked
+        // so malformed scalars like tru and broken separators inside containers get through where parsing would throw
+        bool skip(std::string_view chunk, size_t& i, const StructuralIndex& index);
+        // If the value can end with the input, only scalars can
+        bool can_end() const noexcept;
+    };
+} // namespace SJSON
@@ -1,9 +1,11 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <string_view>
-#include <unordered_map>
-#include <unordered_set>
+#include <utility>
 
 namespace SJSON {
     class sjson_parse_error : public std::runtime_error {
@@ -16,14 +18,17 @@ namespace SJSON {
         inline static sjson_parse_error unexpected_character(char c) {
             return sjson_parse_error("Read unexpected character '" + std::string {c, '\''});
         }
-        inline static sjson_parse_error invalid_token(const std::string& type, const std::string& src) {
-            return sjson_parse_error("Invalid " + type + " of value '" + src + "'");
+        inline static sjson_parse_error invalid_token(const std::string& type, std::string_view src) {
+            return sjson_parse_error("Invalid " + type + " of value '" + std::string(src) + "'");
         }
         inline static sjson_parse_error invalid_escape(const std::string& seq) {
             return sjson_parse_error("Invalid escape sequence '" + seq + "' in string");
         }
-        inline static sjson_parse_error unexpected_token(const std::string& src) {
-            return sjson_parse_error("Unexpected token of value '" + src + "'");
+        inline static sjson_parse_error invalid_utf8(std::string_view escaped) {
+            return sjson_parse_error("Invalid UTF-8 in string " + std::string(escaped));
+        }
+        inline static sjson_parse_error unexpected_token(std::string_view src) {
+            return sjson_parse_error("Unexpected token of value '" + std::string(src) + "'");
         }
         inline static sjson_parse_error unexpected_eof() {
             return sjson_parse_error("Unexpected end of input");
@@ -31,6 +36,15 @@ namespace SJSON {
         inline static sjson_parse_error schema_mismatch() {
             return sjson_parse_error("Input doesn't match the schema");
         }
+        inline static sjson_parse_error incorrect_type(const std::string& expected, std::string_view src) {
+            return sjson_parse_error("Expected " + expected + " but found '" + std::string(src) + "'");
+        }
+        inline static sjson_parse_error invalid_cbor(std::string_view reason) {
+            return sjson_parse_error("Invalid CBOR, " + std::string(reason));
+        }
+        inline static sjson_parse_error value_consumed() {
+            return sjson_parse_error("Cursor already moved past this value");
+        }
     };
     class sjson_internal_parse_error : public std::runtime_error {
     public:
@@ -76,8 +90,28 @@ namespace SJSON {
         False,
     };
 
+    // Every byte belongs to exactly one class, so the lexer only needs one lookup per byte
+    enum class CharClass : uint8_t {
+        Other,
+        Whitespace,
+        Decimal,  // Things numbers could start with
+        Special,  // Things numbers could include
+        Exponent, // Both a number character and a keyword letter
+        Letter,   // Keywords contain only letters
+        Sequence, // A letter that also starts a uXXXX escape
+        Operator,
+        Quote,
+        Backslash,
+    };
+    inline constexpr size_t char_class_count = 10;
+
+    inline constexpr char string_char = '"';
+    inline constexpr char escape_char = '\\';
+    inline constexpr char sequence_escape_char = 'u'; // Follows the format uXXXX -> U+XXXX
+    inline constexpr int sequence_escape_len = 4;
+
     // All operators are single-character
-    inline const std::unordered_map<char, Operators> operator_map {
+    inline constexpr std::pair<char, Operators> operator_pairs[] {
         {',', Operators::Comma},
         {':', Operators::Colon},
         {'[', Operators::ArrayStart},
@@ -85,109 +119,13 @@ namespace SJSON {
         {'{', Operators::ObjectStart},
         {'}', Operators::ObjectEnd},
     };
-    inline const std::unordered_map<std::string_view, Keywords> keyword_map {
+    inline constexpr std::pair<std::string_view, Keywords> keyword_pairs[] {
         {"null", Keywords::Null},
         {"true", Keywords::True},
         {"false", Keywords::False},
     };
-
-    // Things numbers could start with
-    inline const std::unordered_set<char> decimals_set {
-        '-',
-        '0',
-        '1',
-        '2',
-        '3',
-        '4',
-        '5',
-        '6',
-        '7',
-        '8',
-        '9',
-    };
-    // Things numbers could include
-    inline const std::unordered_set<char> special_numbers_set {
-        '.',
-        'e',
-        '+',
-    };
-
-    // Keywords contain only these letters
-    inline const std::unordered_set<char> letters_set {
-        'q',
-        'w',
-        'e',
-        'r',
-        't',
-        'y',
-        'u',
-        'i',
-        'o',
-        'p',
-        'a',
-        's',
-        'd',
-        'f',
-        'g',
-        'h',
-        'j',
-        'k',
-        'l',
-        'z',
-        'x',
-        'c',
-        'v',
-        'b',
-        'n',
-        'm',
-        'Q',
-        'W',
-        'E',
-        'R',
-        'T',
-        'Y',
-        'U',
-        'I',
-        'O',
-        'P',
-        'A',
-        'S',
-        'D',
-        'F',
-        'G',
-        'H',
-        'J',
-        'K',
-        'L',
-        'Z',
-        'X',
-        'C',
-        'V',
-        'B',
-        'N',
-        'M',
-    };
-
-    // Only these are included in the spec
-    inline const std::unordered_set<char> whitespace_set {
-        ' ',
-        '\t',
-        '\n',
-        '\r',
-    };
-
     // Only these are explicitly listed as special characters in the spec (any others will be ignored)
-    enum class EscapeState {
-        None,
-        End,
-        Escaping,
-        Sequence,
-    };
-    inline constexpr char string_char = '"';
-    inline constexpr char escape_char = '\\';
-    inline constexpr char sequence_escape_char = 'u'; // Follows the format uXXXX -> U+XXXX
-    inline constexpr int sequence_escape_len = 4;
-    inline const std::unordered_map<char, char> escape_map {
+    inline constexpr std::pair<char, char> escape_pairs[] {
         {'"', '"'},
         {'\\', '\\'},
         {'/', '/'},
@@ -197,4 +135,135 @@ namespace SJSON {
         {'r', '\r'},
         {'t', '\t'},
     };
+
+    inline constexpr std::array<CharClass, 256> char_classes = []() {
+        std::array<CharClass, 256> table {};
+        for (auto c : std::string_view("\t\n\r ")) table[uint8_t(c)] = CharClass::Whitespace; // Only these are included in the spec
+        for (auto c : std::string_view("-0123456789")) table[uint8_t(c)] = CharClass::Decimal;
+        for (auto c : std::string_view(".+")) table[uint8_t(c)] = CharClass::Special;
+        for (char c = 'a'; c <= 'z'; c++) table[uint8_t(c)] = CharClass::Letter;
+        for (char c = 'A'; c <= 'Z'; c++) table[uint8_t(c)] = CharClass::Letter;
+        for (const auto& [c, op] : operator_pairs) table[uint8_t(c)] = CharClass::Operator;
+        table[uint8_t('e')] = CharClass::Exponent;
+        table[uint8_t(sequence_escape_char)] = CharClass::Sequence;
+        table[uint8_t(string_char)] = CharClass::Quote;
+        table[uint8_t(escape_char)] = CharClass::Backslash;
+        return table;
+    }();
+    inline constexpr std::array<Operators, 256> operator_table = []() {
+        std::array<Operators, 256> table {};
+        for (const auto& [c, op] : operator_pairs) table[uint8_t(c)] = op;
+        return table;
+    }();
+    // Escaped character -> actual character, anything unlisted stays itself
+    inline constexpr std::array<char, 256> unescape_table = []() {
+        std::array<char, 256> table {};
+        for (size_t c = 0; c < table.size(); c++) table[c] = char(c);
+        for (const auto& [k, v] : escape_pairs) table[uint8_t(k)] = v;
+        return table;
+    }();
+    // Actual character -> escaped character, zero if it has no single char escape
+    inline constexpr std::array<char, 256> escape_table = []() {
+        std::array<char, 256> table {};
+        for (const auto& [k, v] : escape_pairs) table[uint8_t(v)] = k;
+        return table;
+    }();
+
+    inline constexpr CharClass char_class(char c) noexcept {
+        return char_classes[uint8_t(c)];
+    }
+    inline constexpr bool is_whitespace(char c) noexcept {
+        return char_class(c) == CharClass::Whitespace;
+    }
+    inline constexpr bool is_letter(char c) noexcept {
+        const auto type = char_class(c);
+        return type == CharClass::Letter || type == CharClass::Exponent || type == CharClass::Sequence;
+    }
+    inline constexpr bool is_operator(char c) noexcept {
+        return char_class(c) == CharClass::Operator;
+    }
+    inline constexpr const Keywords* find_keyword(std::string_view src) noexcept {
+        for (const auto& [k, v] : keyword_pairs)
+            if (k == src) return &v;
+        return nullptr;
+    }
+
+    /*
+        Lexer DFA, the string states replace what used to be a separate escape state
+        Each transition says what to do with the byte and which state comes next
+    */
+    enum class LexState : uint8_t {
+        Unresolved,
+        Operator,
+        Keyword,
+        Number,
+        Fraction, // Number with a fraction or exponent, so it can't be an integer
+        String,
+        Escaping,
+        Sequence,
+        End, // The string has been closed
+    };
+    inline constexpr size_t lex_state_count = 9;
+    enum class LexAction : uint8_t {
+        Error,     // Unexpected character
+        Skip,      // Whitespace that doesn't matter to the token
+        Append,    // Source text is the token text
+        Terminate, // The byte belongs to the next token
+        Escape,    // Start of an escape, the text stops matching the source
+        Unescape,  // Single character escape
+        Hex,       // One of the digits of a uXXXX escape
+    };
+    struct LexTransition {
+        LexAction action;
+        LexState next;
+    };
+    inline constexpr std::array<std::array<LexTransition, char_class_count>, lex_state_count> lex_table = []() {
+        using enum CharClass;
+        std::array<std::array<LexTransition, char_class_count>, lex_state_count> table {};
+        const auto set = [&table](LexState state, CharClass type, LexAction action, LexState next) {
+            table[size_t(state)][size_t(type)] = {action, next};
+        };
+        const auto set_all = [&table](LexState state, LexAction action, LexState next) {
+            for (auto& transition : table[size_t(state)]) transition = {action, next};
+        };
+
+        set_all(LexState::Unresolved, LexAction::Error, LexState::Unresolved);
+        set(LexState::Unresolved, Whitespace, LexAction::Skip, LexState::Unresolved);
+        set(LexState::Unresolved, Operator, LexAction::Append, LexState::Operator);
+        set(LexState::Unresolved, Decimal, LexAction::Append, LexState::Number);
+        set(LexState::Unresolved, Exponent, LexAction::Append, LexState::Keyword);
+        set(LexState::Unresolved, Letter, LexAction::Append, LexState::Keyword);
+        set(LexState::Unresolved, Sequence, LexAction::Append, LexState::Keyword);
+        set(LexState::Unresolved, Quote, LexAction::Append, LexState::String);
+
+        set_all(LexState::Operator, LexAction::Terminate, LexState::Unresolved);
+
+        set_all(LexState::Keyword, LexAction::Terminate, LexState::Unresolved);
+        set(LexState::Keyword, Exponent, LexAction::Append, LexState::Keyword);
+        set(LexState::Keyword, Letter, LexAction::Append, LexState::Keyword);
+        set(LexState::Keyword, Sequence, LexAction::Append, LexState::Keyword);
+
+        set_all(LexState::Number, LexAction::Terminate, LexState::Unresolved);
+        set(LexState::Number, Decimal, LexAction::Append, LexState::Number);
+        set(LexState::Number, Special, LexAction::Append, LexState::Fraction);
+        set(LexState::Number, Exponent, LexAction::Append, LexState::Fraction);
+        table[size_t(LexState::Fraction)] = table[size_t(LexState::Number)];
+        set(LexState::Fraction, Decimal, LexAction::Append, LexState::Fraction);
+
+        set_all(LexState::String, LexAction::Append, LexState::String);
+        set(LexState::String, Quote, LexAction::Append, LexState::End);
+        set(LexState::String, Backslash, LexAction::Escape, LexState::Escaping);
+
+        set_all(LexState::Escaping, LexAction::Unescape, LexState::String);
+        set(LexState::Escaping, Sequence, LexAction::Skip, LexState::Sequence);
+
+        set_all(LexState::Sequence, LexAction::Hex, LexState::Sequence);
+
+        // String termination doesn't depend on the proceeding character
+        set_all(LexState::End, LexAction::Terminate, LexState::Unresolved);
+        return table;
+    }();
+    inline constexpr LexTransition lex_transition(LexState state, char c) noexcept {
+        return lex_table[size_t(state)][size_t(char_class(c))];
+    }
 } // namespace SJSON
@@ -0,0 +1,441 @@
+#include "tape.hpp"
+#include "syntax.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <variant>
+
+namespace SJSON {
+    static constexpr uint64_t payload_mask = (uint64_t(1) << 56) - 1;
+    static constexpr uint64_t count_shift = 32;
+    static constexpr uint64_t max_count = 0xffffff;
+
+    static constexpr uint64_t entry(TapeTag tag, uint64_t payload = 0) noexcept {
+        return (uint64_t(tag) << 56) | payload;
+    }
+
+    TapeRef::TapeRef(const uint64_t* entries, const char* strings, size_t i):
+        entries(entries),
+        strings(strings),
+        i(i) {}
+    TapeTag TapeRef::tag() const noexcept {
+        return TapeTag(entries[i] >> 56);
+    }
+    uint64_t TapeRef::payload() const noexcept {
+        return entries[i] & payload_mask;
+    }
+    uint64_t TapeRef::next() const noexcept {
+        return entries[i + 1];
+    }
+    size_t TapeRef::after() const noexcept {
+        switch (tag()) {
+            case TapeTag::Integer:
+            case TapeTag::Unsigned:
+            case TapeTag::Number: return i + 2;
+            case TapeTag::ObjectStart:
+            case TapeTag::ArrayStart: return size_t(payload() & 0xffffffff);
+            default: return i + 1;
+        }
+    }
+    std::string_view TapeRef::text() const noexcept {
+        const char* at = strings + payload();
+        uint32_t length;
+        std::memcpy(&length, at, sizeof(length));
+        return std::string_view(at + sizeof(length), length);
+    }
+    // Keeps JSValue's behaviour of throwing on the wrong type
+    void TapeRef::expect(TapeTag t) const {
+        if (tag() != t) throw std::bad_variant_access();
+    }
+
+    JSValueType TapeRef::type() const {
+        switch (tag()) {
+            case TapeTag::Null: return JSValueType::Null;
+            case TapeTag::True:
+            case TapeTag::False: return JSValueType::Boolean;
+            case TapeTag::Integer:
+            case TapeTag::Unsigned:
+            case TapeTag::Number:
+            case TapeTag::RawNumber: return JSValueType::Number;
+            case TapeTag::String: return JSValueType::String;
+            case TapeTag::ObjectStart: return JSValueType::Object;
+            case TapeTag::ArrayStart: return JSValueType::Array;
+            default: break;
+        }
+        throw sjson_internal_parse_error::invalid_token_type("a tape");
+    }
+    const char* TapeRef::type_str() const noexcept {
+        try {
+            return type_to_string(type());
+        } catch (...) {
+            return "Error";
+        }
+    }
+    bool TapeRef::is_null() const noexcept {
+        return tag() == TapeTag::Null;
+    }
+    bool TapeRef::is_number() const noexcept {
+        const auto t = tag();
+        return t == TapeTag::Integer || t == TapeTag::Unsigned || t == TapeTag::Number || t == TapeTag::RawNumber;
+    }
+    bool TapeRef::is_integer() const noexcept {
+        return tag() == TapeTag::Integer || tag() == TapeTag::Unsigned;
+    }
+    bool TapeRef::is_raw_number() const noexcept {
+        return tag() == TapeTag::RawNumber;
+    }
+    bool TapeRef::is_boolean() const noexcept {
+        return tag() == TapeTag::True || tag() == TapeTag::False;
+    }
+    bool TapeRef::is_string() const noexcept {
+        return tag() == TapeTag::String;
+    }
+    bool TapeRef::is_object() const noexcept {
+        return tag() == TapeTag::ObjectStart;
+    }
+    bool TapeRef::is_array() const noexcept {
+        return tag() == TapeTag::ArrayStart;
+    }
+    // Front to back in one pass, keys are read along with their values
+    std::string TapeRef::to_string() const {
+        std::string out;
+        VectorStack<TapeTag> open; // Start tags of the containers being written
+        bool first = true;
+        char digits[24];
+        const size_t end = after();
+        for (TapeRef at = *this; at.i < end;) {
+            const auto t = at.tag();
+            if (t == TapeTag::ObjectEnd || t == TapeTag::ArrayEnd) {
+                out += t == TapeTag::ObjectEnd ? '}' : ']';
+                open.pop();
+                first = false;
+                at.i++;
+                continue;
+            }
+            if (!first) out += ',';
+            first = false;
+            if (open.has_top() && open.top() == TapeTag::ObjectStart) {
+                jsstring_escape(out, at.text());
+                out += ':';
+                at.i++;
+            }
+            switch (at.tag()) {
+                case TapeTag::Null: out += "null"; break;
+                case TapeTag::True: out += "true"; break;
+                case TapeTag::False: out += "false"; break;
+                case TapeTag::Integer: out.append(digits, std::to_chars(digits, digits + sizeof(digits), at.integer()).ptr); break;
+                case TapeTag::Unsigned: out.append(digits, std::to_chars(digits, digits + sizeof(digits), at.unsigned_integer()).ptr); break;
+                case TapeTag::Number: num_to_string(out, at.number()); break;
+                case TapeTag::RawNumber: out += at.text(); break;
+                case TapeTag::String: jsstring_escape(out, at.text()); break;
+                case TapeTag::ObjectStart:
+                case TapeTag::ArrayStart:
+                    out += at.is_object() ? '{' : '[';
+                    open.push(at.tag());
+                    first = true;
+                    at.i++;
+                    continue;
+                default: throw sjson_internal_parse_error::invalid_token_type("a tape");
+            }
+            at.i = at.after();
+        }
+        return out;
+    }
+    // Without recursion, references point at the containers that are still open like Parse's
+    JSValue TapeRef::to_value(const ParseOptions& options) const {
+        JSValue root;
+        VectorStack<JSValue*> references;
+        const size_t end = after();
+        for (TapeRef at = *this; at.i < end;) {
+            const auto t = at.tag();
+            if (t == TapeTag::ObjectEnd || t == TapeTag::ArrayEnd) {
+                references.pop();
+                at.i++;
+                continue;
+            }
+            JSValue* slot = &root;
+            if (references.has_top()) {
+                if (references.top()->is_array()) {
+                    auto& array = references.top()->array();
+                    array.emplace_back();
+                    slot = &array.back();
+                } else {
+                    slot = &references.top()->object()[JSKey(at.text(), options.memory())];
+                    at.i++;
+                }
+            }
+            switch (at.tag()) {
+                case TapeTag::Null: break;
+                case TapeTag::True:
+                case TapeTag::False: *slot = JSValue(at.boolean()); break;
+                case TapeTag::Integer: *slot = JSValue(at.integer()); break;
+                case TapeTag::Unsigned: *slot = JSValue(at.unsigned_integer()); break;
+                case TapeTag::Number: *slot = JSValue(at.number()); break;
+                case TapeTag::RawNumber: *slot = JSValue(JSRawNumber {JSString(at.text(), options.memory())}); break;
+                case TapeTag::String: *slot = JSValue(at.text(), options.memory()); break;
+                case TapeTag::ObjectStart:
+                    *slot = JSValue(JSObject(options.objects, options.memory()));
+                    references.push(slot);
+                    at.i++;
+                    continue;
+                case TapeTag::ArrayStart:
+                    *slot = JSValue(JSArray(options.memory()));
+                    references.push(slot);
+                    at.i++;
+                    continue;
+                default: throw sjson_internal_parse_error::invalid_token_type("a tape");
+            }
+            at.i = at.after();
+        }
+        return root;
+    }
+
+    JSNumber TapeRef::number() const {
+        switch (tag()) {
+            case TapeTag::Integer: return JSNumber(std::bit_cast<JSInteger>(next()));
+            case TapeTag::Unsigned: return JSNumber(next());
+            case TapeTag::Number: return std::bit_cast<JSNumber>(next());
+            case TapeTag::RawNumber: return to_double(text());
+            default: throw std::bad_variant_access();
+        }
+    }
+    JSInteger TapeRef::integer() const {
+        expect(TapeTag::Integer);
+        return std::bit_cast<JSInteger>(next());
+    }
+    JSUnsigned TapeRef::unsigned_integer() const {
+        expect(TapeTag::Unsigned);
+        return next();
+    }
+    std::string_view TapeRef::raw_number() const {
+        expect(TapeTag::RawNumber);
+        return text();
+    }
+    JSBoolean TapeRef::boolean() const {
+        if (!is_boolean()) throw std::bad_variant_access();
+        return tag() == TapeTag::True;
+    }
+    std::string_view TapeRef::string_view() const {
+        expect(TapeTag::String);
+        return text();
+    }
+    TapeObject TapeRef::object() const {
+        expect(TapeTag::ObjectStart);
+        return TapeObject(*this);
+    }
+    TapeArray TapeRef::array() const {
+        expect(TapeTag::ArrayStart);
+        return TapeArray(*this);
+    }
+
+    TapeObject::TapeObject(TapeRef container):
+        container(container) {}
+    size_t TapeObject::size() const noexcept {
+        const auto stored = container.payload() >> count_shift;
+        return stored < max_count ? size_t(stored) : size_t(std::distance(begin(), end()));
+    }
+    bool TapeObject::empty() const noexcept {
+        return begin() == end();
+    }
+    TapeObject::iterator TapeObject::begin() const {
+        return iterator(TapeRef(container.entries, container.strings, container.i + 1));
+    }
+    TapeObject::iterator TapeObject::end() const {
+        return iterator(TapeRef(container.entries, container.strings, container.after() - 1)); // The end entry
+    }
+    TapeObject::iterator TapeObject::find(std::string_view key) const {
+        const auto last = end();
+        for (auto it = begin(); it != last; ++it)
+            if ((*it).key == key) return it;
+        return last;
+    }
+    bool TapeObject::contains(std::string_view key) const {
+        return find(key) != end();
+    }
+    size_t TapeObject::count(std::string_view key) const {
+        return size_t(std::count_if(begin(), end(), [key](const TapeField& field) { return field.key == key; }));
+    }
+    TapeRef TapeObject::at(std::string_view key) const {
+        const auto it = find(key);
+        if (it == end()) throw std::out_of_range("TapeObject::at(): no member named " + jsstring_escape(key));
+        return (*it).value;
+    }
+    TapeRef TapeObject::operator[](std::string_view key) const {
+        return at(key);
+    }
+
+    TapeArray::TapeArray(TapeRef container):
+        container(container) {}
+    size_t TapeArray::size() const noexcept {
+        const auto stored = container.payload() >> count_shift;
+        return stored < max_count ? size_t(stored) : size_t(std::distance(begin(), end()));
+    }
+    bool TapeArray::empty() const noexcept {
+        return begin() == end();
+    }
+    TapeArray::iterator TapeArray::begin() const {
+        return iterator(TapeRef(container.entries, container.strings, container.i + 1));
+    }
+    TapeArray::iterator TapeArray::end() const {
+        return iterator(TapeRef(container.entries, container.strings, container.after() - 1));
+    }
+    TapeRef TapeArray::at(size_t index) const {
+        const auto last = end();
+        auto it = begin();
+        for (; index && it != last; index--) ++it;
+        if (it == last) throw std::out_of_range("TapeArray::at(): index past the end");
+        return *it;
+    }
+    TapeRef TapeArray::operator[](size_t index) const {
+        return at(index);
+    }
+
+    /*
+        Reserved from the source's size so a typical document never has to grow either buffer
+        Strings can't take much more room than their quotes and separators did, and capacity that's never touched isn't resident
+    */
+    Tape Tape::string(std::string_view src, ParseOptions options) {
+        Tape tape;
+        tape.reserve(src.size() / 4 + 2, src.size() + 8);
+        TapeBuilder builder(tape, options);
+        Events(builder, options).feed(src).finish();
+        return tape;
+    }
+    Tape Tape::stream(JSONStream&& src, ParseOptions options) {
+        Tape tape;
+        TapeBuilder builder(tape, options);
+        Events(std::move(src), builder, options).all();
+        return tape;
+    }
+    Tape Tape::file(const std::string& path, ParseOptions options) {
+        MappedFile mapped(path);
+        return file(mapped, options);
+    }
+    Tape Tape::file(MappedFile& mapped, ParseOptions options) {
+        const auto src = mapped.view();
+        Tape tape;
+        tape.reserve(src.size() / 4 + 2, src.size() + 8);
+        TapeBuilder builder(tape, options);
+        Events events(builder, options);
+        for (size_t pos = 0; pos < src.size(); pos += MappedFile::window) {
+            events.feed(src.substr(pos, MappedFile::window));
+            mapped.release(pos + MappedFile::window);
+        }
+        events.finish();
+        return tape;
+    }
+    TapeRef Tape::root() const {
+        if (entries.empty()) throw std::out_of_range("Tape::root(): nothing was parsed");
+        return TapeRef(entries.data(), strings.data());
+    }
+    bool Tape::empty() const noexcept {
+        return entries.empty();
+    }
+    size_t Tape::size() const noexcept {
+        return entries.size();
+    }
+    const std::vector<uint64_t>& Tape::tape() const noexcept {
+        return entries;
+    }
+    const std::string& Tape::string_buffer() const noexcept {
+        return strings;
+    }
+    void Tape::reserve(size_t entry_count, size_t string_bytes) {
+        entries.reserve(entry_count);
+        strings.reserve(string_bytes);
+    }
+    void Tape::clear() noexcept {
+        entries.clear();
+        strings.clear();
+    }
+    std::string Tape::to_string() const {
+        return empty() ? "" : root().to_string();
+    }
+
+    TapeBuilder::TapeBuilder(Tape& tape, ParseOptions options):
+        tape(&tape),
+        options(options) {}
+    // Arrays count their elements as they start, objects count their keys
+    void TapeBuilder::element() {
+        if (!open.has_top()) return;
+        auto& start = tape->entries[open.top()];
+        if (TapeTag(start >> 56) == TapeTag::ArrayStart && ((start >> count_shift) & max_count) != max_count)
+            start += uint64_t(1) << count_shift;
+    }
+    void TapeBuilder::push(TapeTag tag, uint64_t payload) {
+        tape->entries.push_back(entry(tag, payload));
+    }
+    uint64_t TapeBuilder::text(std::string_view src) {
+        if (src.size() > std::numeric_limits<uint32_t>::max()) throw std::length_error("Tape: string longer than 4 GiB");
+        const uint64_t offset = tape->strings.size();
+        const auto length = uint32_t(src.size());
+        tape->strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        tape->strings.append(src);
+        return offset;
+    }
+    void TapeBuilder::start(TapeTag tag) {
+        element();
+        open.push(tape->entries.size());
+        push(tag);
+    }
+    // The start learns where to jump to, the end where it started
+    void TapeBuilder::end(TapeTag tag) {
+        const size_t start = open.top();
+        open.pop();
+        const uint64_t past = tape->entries.size() + 1;
+        if (past > std::numeric_limits<uint32_t>::max()) throw std::length_error("Tape: more than 4G entries");
+        tape->entries[start] |= past;
+        push(tag, start);
+    }
+
+    void TapeBuilder::start_object() {
+        start(TapeTag::ObjectStart);
+    }
+    void TapeBuilder::key(std::string_view key) {
+        auto& start = tape->entries[open.top()];
+        if (((start >> count_shift) & max_count) != max_count) start += uint64_t(1) << count_shift;
+        push(TapeTag::String, text(key));
+    }
+    void TapeBuilder::end_object() {
+        end(TapeTag::ObjectEnd);
+    }
+    void TapeBuilder::start_array() {
+        start(TapeTag::ArrayStart);
+    }
+    void TapeBuilder::end_array() {
+        end(TapeTag::ArrayEnd);
+    }
+    void TapeBuilder::string(std::string_view value) {
+        element();
+        push(TapeTag::String, text(value));
+    }
+    void TapeBuilder::parsed_number(std::string_view src, const ParsedNumber& value) {
+        element();
+        switch (value.kind) {
+            case NumberKind::Integer:
+                push(TapeTag::Integer);
+                tape->entries.push_back(std::bit_cast<uint64_t>(value.integer));
+                break;
+            case NumberKind::Unsigned:
+                push(TapeTag::Unsigned);
+                tape->entries.push_back(value.uinteger);
+                break;
+            case NumberKind::Double:
+                push(TapeTag::Number);
+                tape->entries.push_back(std::bit_cast<uint64_t>(value.number));
+                break;
+            case NumberKind::Raw: push(TapeTag::RawNumber, text(src)); break;
+        }
+    }
+    void TapeBuilder::boolean(bool value) {
+        element();
+        push(value ? TapeTag::True : TapeTag::False);
+    }
+    void TapeBuilder::null() {
+        element();
+        push(TapeTag::Null);
+    }
+} // namespace SJSON
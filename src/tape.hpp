@@ -0,0 +1,242 @@
+#pragma once
+#include "events.hpp"
+#include "file.hpp"
+#include "options.hpp"
+#include "util.hpp"
+#include "value.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SJSON {
+    // Top byte of a tape entry, the other 56 bits are its payload
+    enum class TapeTag : uint8_t {
+        Null = 'n',
+        True = 't',
+        False = 'f',
+        Integer = 'l',     // The next entry is the JSInteger
+        Unsigned = 'u',    // The next entry is the JSUnsigned
+        Number = 'd',      // The next entry is the JSNumber's bits
+        RawNumber = 'R',   // Offset of its text in the strings
+        String = 's',      // Offset in the strings, where a 32 bit length comes before the chars
+        ObjectStart = '{', // Member count (saturated at 24 bits) above the index right after the matching end
+        ObjectEnd = '}',   // Index of the matching start
+        ArrayStart = '[',
+        ArrayEnd = ']',
+    };
+
+    class TapeObject;
+    class TapeArray;
+
+    /*
+        A value on a tape, reads like a const JSValue
+        Only points into the tape and its strings so it's as cheap to copy as a pointer and lives as long as they do
+    */
+    class TapeRef {
+    protected:
+        friend class TapeObject;
+        friend class TapeArray;
+        const uint64_t* entries = nullptr;
+        const char* strings = nullptr;
+        size_t i = 0;
+
+        TapeTag tag() const noexcept;
+        uint64_t payload() const noexcept;
+        uint64_t next() const noexcept; // The entry after this one, for numbers
+        size_t after() const noexcept;  // Index of whatever follows the value
+        std::string_view text() const noexcept;
+        void expect(TapeTag t) const;
+
+    public:
+        TapeRef() = default;
+        TapeRef(const uint64_t* entries, const char* strings, size_t i = 0); // Laid out like a Tape's
+
+        JSValueType type() const;
+        const char* type_str() const noexcept;
+        bool is_null() const noexcept;
+        bool is_number() const noexcept;
+        bool is_integer() const noexcept; // Numbers stored exactly as a JSInteger or JSUnsigned
+        bool is_raw_number() const noexcept;
+        bool is_boolean() const noexcept;
+        bool is_string() const noexcept;
+        bool is_object() const noexcept;
+        bool is_array() const noexcept;
+        std::string to_string() const; // Always compact
+        JSValue to_value(const ParseOptions& options = {}) const; // Built like Parse would
+
+        // Throw std::bad_variant_access on the wrong type like JSValue
+        JSNumber number() const; // Any number as a JSNumber
+        JSInteger integer() const;
+        JSUnsigned unsigned_integer() const;
+        std::string_view raw_number() const;
+        JSBoolean boolean() const;
+        std::string_view string_view() const;
+        TapeObject object() const;
+        TapeArray array() const;
+    };
+
+    struct TapeField {
+        std::string_view key;
+        TapeRef value;
+    };
+
+    // Members in the order they were parsed, duplicate keys are all kept
+    class TapeObject {
+    protected:
+        friend class TapeRef;
+        TapeRef container;
+
+        TapeObject(TapeRef container);
+
+    public:
+        class iterator {
+        protected:
+            TapeRef at;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = TapeField;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            inline iterator(TapeRef at):
+                at(at) {}
+
+            inline TapeField operator*() const { return {at.text(), TapeRef(at.entries, at.strings, at.i + 1)}; }
+            inline iterator& operator++() {
+                at.i = TapeRef(at.entries, at.strings, at.i + 1).after();
+                return *this;
+            }
+            inline iterator operator++(int) {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+            inline bool operator==(const iterator& it) const { return at.i == it.at.i; }
+        };
+        typedef iterator const_iterator;
+
+        TapeObject() = default;
+
+        size_t size() const noexcept; // Counted once there are too many members to store
+        bool empty() const noexcept;
+        iterator begin() const;
+        iterator end() const;
+        iterator find(std::string_view key) const; // First member with the key
+        bool contains(std::string_view key) const;
+        size_t count(std::string_view key) const;
+        TapeRef at(std::string_view key) const; // Throws std::out_of_range if the member is missing
+        TapeRef operator[](std::string_view key) const; // Same as at(), nothing can be inserted
+    };
+
+    class TapeArray {
+    protected:
+        friend class TapeRef;
+        TapeRef container;
+
+        TapeArray(TapeRef container);
+
+    public:
+        class iterator {
+        protected:
+            TapeRef at;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = TapeRef;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            inline iterator(TapeRef at):
+                at(at) {}
+
+            inline TapeRef operator*() const { return at; }
+            inline const TapeRef* operator->() const { return &at; }
+            inline iterator& operator++() {
+                at.i = at.after();
+                return *this;
+            }
+            inline iterator operator++(int) {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+            inline bool operator==(const iterator& it) const { return at.i == it.at.i; }
+        };
+        typedef iterator const_iterator;
+
+        TapeArray() = default;
+
+        size_t size() const noexcept;
+        bool empty() const noexcept;
+        iterator begin() const;
+        iterator end() const;
+        TapeRef at(size_t index) const; // Jumps over the elements before it, throws std::out_of_range past the end
+        TapeRef operator[](size_t index) const;
+    };
+
+    /*
+        A whole document as one flat array of tagged 64 bit entries with every string in a single side buffer
+        Containers store where they end so anything can be skipped in one jump, and reading it front to back is linear
+        Objects keep their members in parse order whatever ParseOptions::objects says
+    */
+    class Tape {
+    protected:
+        friend class TapeBuilder;
+        std::vector<uint64_t> entries;
+        std::string strings;
+
+    public:
+        Tape() = default;
+        Tape(const Tape&) = default;
+        Tape& operator=(const Tape&) = default;
+        Tape(Tape&&) noexcept = default;
+        Tape& operator=(Tape&&) noexcept = default;
+        ~Tape() = default;
+
+        // Same tokenizer and auto-correction as Parse, through Events
+        static Tape string(std::string_view src, ParseOptions options = {});
+        static Tape stream(JSONStream&& src, ParseOptions options = {});
+        static Tape file(const std::string& path, ParseOptions options = {}); // Mapped and released as it's parsed like Parse::file()
+        static Tape file(MappedFile& file, ParseOptions options = {});
+
+        TapeRef root() const; // Throws std::out_of_range if nothing was parsed
+        bool empty() const noexcept;
+        size_t size() const noexcept; // Entries
+        const std::vector<uint64_t>& tape() const noexcept;
+        const std::string& string_buffer() const noexcept;
+        void reserve(size_t entries, size_t string_bytes);
+        void clear() noexcept; // Capacity stays for the next document
+        std::string to_string() const;
+    };
+
+    // Appends a document to a tape as it's parsed, for push parses with Events
+    class TapeBuilder : public Handler {
+    protected:
+        Tape* tape;
+        ParseOptions options;
+        VectorStack<size_t> open; // Starts of the containers that haven't ended
+
+        void element();
+        void push(TapeTag tag, uint64_t payload = 0);
+        uint64_t text(std::string_view src); // Offset of the stored text
+        void start(TapeTag tag);
+        void end(TapeTag tag);
+
+    public:
+        explicit TapeBuilder(Tape& tape, ParseOptions options = {});
+
+        void start_object() override;
+        void key(std::string_view key) override;
+        void end_object() override;
+        void start_array() override;
+        void end_array() override;
+        void string(std::string_view value) override;
+        void parsed_number(std::string_view src, const ParsedNumber& value) override;
+        void boolean(bool value) override;
+        void null() override;
+    };
+} // namespace SJSON
@@ -1,7 +1,14 @@
 #pragma once
 #include "sjson.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace SJSON {
     class Tester {
@@ -15,6 +22,61 @@ namespace SJSON {
         inline static void log_pass(const std::string& src, const std::string& output) {
             std::cout << "[PASSED] '" << src << "' -> " << output << "\n";
         }
+        // Writes events back as JSON in the order they came in
+        class Recorder : public Handler {
+        protected:
+            bool comma = false;
+
+            inline void value(std::string_view text) {
+                if (comma) out += ',';
+                out += text;
+                comma = true;
+            }
+
+        public:
+            std::string out;
+
+            inline void start_object() override {
+                value("{");
+                comma = false;
+            }
+            inline void key(std::string_view key) override {
+                value(jsstring_escape(key));
+                out += ':';
+                comma = false;
+            }
+            inline void end_object() override {
+                out += '}';
+                comma = true;
+            }
+            inline void start_array() override {
+                value("[");
+                comma = false;
+            }
+            inline void end_array() override {
+                out += ']';
+                comma = true;
+            }
+            inline void string(std::string_view v) override { value(jsstring_escape(v)); }
+            inline void number(std::string_view src) override { value(src); }
+            inline void boolean(bool v) override { value(v ? "true" : "false"); }
+            inline void null() override { value("null"); }
+        };
+
+        // Simulate one character streams cuz it's the worse case scenario
+        inline static JSONStream one_char_stream(const std::string& src) {
+            return [&src, i = size_t(0)]() mutable -> std::string {
+                if (i >= src.size()) return "";
+                return std::string {src[i++]};
+            };
+        }
+
+        // Unique to the run like a cache's temporary file, so runs side by side don't write over each other's files
+        inline static std::filesystem::path temp_path(const char* extension) {
+            static const auto run = std::to_string(std::random_device()());
+            return std::filesystem::temp_directory_path() / ("sjson_test" + run + extension);
+        }
+
         inline static void log(bool passed, const std::string& src, const std::string& output) {
             if (passed)
                 return log_pass(src, output);
@@ -30,18 +92,187 @@ namespace SJSON {
             int errors_passed = 0;
             int internal_errors = 0;
         } tests;
+        ParseOptions options;
+        std::vector<std::string> labels; // Listened to in every parse, what they get is written before the parsed value
+        std::vector<std::string> kept;   // Kept in every parse
+        bool events = false;             // Parse with Events and write the events back instead of building values
+        bool pushed = false;             // Feed the input instead of streaming it
+        bool collect = false;            // Collect labels and write down values() as they come instead of listening
+        bool resync = false;             // Resync malformed documents and write down where they were
+        bool mapped = false;             // Whole strings go through a mapped file, fed a page at a time
+        bool read_ahead = false;         // Whole strings are read ahead into a small ring of tiny buffers
+        bool gzipped = false;            // Whole strings are compressed and inflated a few bytes at a time
+        bool binary = false;             // Strings are parsed as JSON, written as CBOR and that's what gets parsed
+        bool taped = false;              // Parse into a Tape and write it back from the tape
+        bool cached = false;             // Whole strings go through a tape cache file that's mapped back
 
         inline Tester() { run(); };
         ~Tester() = default;
 
         inline std::string string(const std::string& src) const {
-            // Simulate one character streams cuz it's the worse case scenario
-            Parse json([&src, i = 0]() mutable -> std::string {
-                if (i >= src.size()) return "";
-                return std::string {src[i++]};
+            if (pushed) return fed(src, 1);
+            if (binary) return cbor(src, 1);
+            if (taped) return Tape::stream(one_char_stream(src), options).to_string();
+            if (events) {
+                Recorder recorder;
+                Events::stream(one_char_stream(src), recorder, options);
+                return recorder.out;
+            }
+            Parse json(one_char_stream(src), options);
+            return listened(json, [&json]() { json.all(); });
+        }
+        // Whole strings are the best case scenario where tokens stay views into the input
+        inline std::string whole(const std::string& src) const {
+            if (pushed) return fed(src, src.size());
+            if (binary) return cbor(src, src.size());
+            if (cached) return cache_file(src);
+            if (taped) return Tape::string(src, options).to_string();
+            if (mapped) return mapped_file(src);
+            if (gzipped) return inflated(gzip(src));
+            if (read_ahead) {
+                std::istringstream in(src);
+                ReadAhead input(in, 2, 3); // Fills up long before the parser catches up
+                Parse json(options);
+                return listened(json, [&json, &input]() { json.feed(input).finish(); });
+            }
+            if (events) {
+                Recorder recorder;
+                Events::string(src, recorder, options);
+                return recorder.out;
+            }
+            if (labels.empty() && kept.empty()) return Parse::string(src, options).to_string();
+            Parse json([&src, done = false]() mutable -> std::string {
+                if (done) return "";
+                done = true;
+                return src;
+            },
+                options);
+            return listened(json, [&json]() { json.all(); });
+        }
+        // Pieces of size bytes are fed, each one only lives until it's parsed
+        inline std::string fed(const std::string& src, size_t size) const {
+            const auto feed = [&src, size](auto& parser) {
+                for (size_t i = 0; i < src.size(); i += size) {
+                    const std::string piece = src.substr(i, size);
+                    parser.feed(piece);
+                }
+                parser.finish();
+            };
+            if (events) {
+                Recorder recorder;
+                Events parser(recorder, options);
+                feed(parser);
+                return recorder.out;
+            }
+            Parse json(options);
+            if (!collect) return listened(json, [&json, &feed]() { feed(json); });
+            std::string out;
+            for (const auto& label : labels) json.collect(label);
+            for (size_t i = 0; i < src.size(); i += size) {
+                json.feed(src.substr(i, size));
+                for (const auto& value : json.values()) out += value.to_string() + " ";
+            }
+            json.finish();
+            for (const auto& value : json.values()) out += value.to_string() + " ";
+            return out + json.to_string();
+        }
+        // The file's removed once it's mapped, the mapping keeps it around
+        inline std::string mapped_file(const std::string& src) const {
+            const auto path = temp_path(".json");
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << src;
+            }
+            MappedFile file(path.string());
+            std::filesystem::remove(path);
+            Parse json(options);
+            return listened(json, [&json, &file]() { json.feed(file, 4096).finish(); });
+        }
+        // Opened twice, the second time has to map what the first one wrote
+        inline std::string cache_file(const std::string& src) const {
+            const auto path = temp_path(".json");
+            const auto cache_path = temp_path(".tape");
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << src;
+            }
+            std::filesystem::remove(cache_path);
+            const auto built = CachedTape::open(path.string(), cache_path.string(), options).to_string();
+            const auto cache = CachedTape::open(path.string(), cache_path.string(), options);
+            std::filesystem::remove(path);
+            std::filesystem::remove(cache_path);
+            if (cache.rebuilt()) return "rebuilt a fresh cache";
+            return cache.to_string() == built ? built : "mapped " + cache.to_string() + " but built " + built;
+        }
+        inline std::string inflated(const std::string& compressed) const {
+            Parse json(options);
+            return listened(json, [&json, &compressed]() {
+                json.feed(GzipReader(pieces(compressed), false, 3), 5).finish();
             });
-            json.all();
-            return json.to_string();
+        }
+        // Hands out the string as whatever size is asked for
+        inline static ByteReader pieces(const std::string& src) {
+            return [&src, i = size_t(0)](char* data, size_t size) mutable -> size_t {
+                size = std::min(size, src.size() - i);
+                std::copy_n(src.data() + i, size, data);
+                i += size;
+                return size;
+            };
+        }
+        inline std::string cbor(const std::string& src, size_t size) const {
+            const auto bytes = CBORWriter::to_string(Parse::string(src, {.raw_numbers = options.raw_numbers}));
+            return decoded(bytes, size);
+        }
+        // Pieces of size bytes like fed(), options.format has to be CBOR
+        inline std::string decoded(const std::string& bytes, size_t size) const {
+            Parse json(options);
+            return listened(json, [&json, &bytes, size]() {
+                for (size_t i = 0; i < bytes.size(); i += size) json.feed(std::string_view(bytes).substr(i, size));
+                json.finish();
+            });
+        }
+        inline void decoded(const std::string& bytes, const std::string& expected) {
+            tests.parsing_total++;
+            try {
+                auto output = decoded(bytes, 1);
+                if (output == expected) output = decoded(bytes, bytes.size());
+                log(output == expected, jsstring_escape(bytes), output);
+                tests.parsing_passed += output == expected;
+            } catch (const sjson_parse_error& err) {
+                log_fail(jsstring_escape(bytes), err.what());
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(jsstring_escape(bytes), err.what());
+                tests.internal_errors++;
+            }
+        }
+        inline void decoded_error(const std::string& bytes) {
+            tests.errors_total++;
+            try {
+                log_fail(jsstring_escape(bytes), decoded(bytes, 1));
+            } catch (const sjson_parse_error& err) {
+                log_pass(jsstring_escape(bytes), err.what());
+                tests.errors_passed++;
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(jsstring_escape(bytes), err.what());
+                tests.internal_errors++;
+            }
+        }
+        inline std::string listened(Parse& json, const std::function<void()>& read) const {
+            std::string out;
+            if (collect) {
+                for (const auto& label : labels) json.collect(label);
+                for (const auto& value : json.values()) out += value.to_string() + " "; // Pulls the stream as it goes
+                return out + json.to_string();
+            }
+            for (const auto& label : labels) {
+                json.listen(label, [&out, label](const JSValue& value) {
+                    out += label + "=" + value.to_string() + " ";
+                });
+            }
+            for (const auto& label : kept) json.keep(label);
+            if (resync) json.resync([&out](const sjson_parse_error&) { out += "error "; });
+            read();
+            return out + json.to_string();
         }
         inline void section(const char* name) const {
             std::cout << "[SECTION] Now testing " << name << '\n';
@@ -51,6 +282,17 @@ namespace SJSON {
             try {
                 auto output = string(src);
                 log_fail(src, output); // Error if success
+                return;
+            } catch (const sjson_parse_error& err) {
+                // Expected, the whole string has to error too
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(src, err.what());
+                tests.internal_errors++;
+                return;
+            }
+            try {
+                auto output = whole(src);
+                log_fail(src, output, " (Whole String) ");
             } catch (const sjson_parse_error& err) {
                 log_pass(src, err.what()); // Success if error
                 tests.errors_passed++;
@@ -64,6 +306,10 @@ namespace SJSON {
             try {
                 auto output = string(src);
                 bool passed = output == expected;
+                if (passed) {
+                    output = whole(src);
+                    passed = output == expected;
+                }
                 log(passed, src, output);
                 tests.parsing_passed += passed;
             } catch (const sjson_parse_error& err) {
@@ -76,11 +322,126 @@ namespace SJSON {
         inline void test(const std::string& src) {
             return test(src, src);
         }
+        // Cursor tests read whatever they need out of the document and write it down
+        inline void cursor(const std::string& src, const std::string& expected, const std::function<std::string(Cursor&)>& read) {
+            tests.parsing_total++;
+            try {
+                Cursor doc(src, options);
+                const auto output = read(doc);
+                log(output == expected, src, output);
+                tests.parsing_passed += output == expected;
+            } catch (const sjson_parse_error& err) {
+                log_fail(src, err.what());
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(src, err.what());
+                tests.internal_errors++;
+            }
+        }
+        // Documents are written down as they're delivered, sorted if they could come in any order
+        inline std::string parallel(const std::string& src, ParallelOptions parallel) const {
+            std::vector<std::string> documents;
+            ParallelParse json(options, parallel);
+            json.documents([&documents](const JSValue& value) { documents.push_back(value.to_string()); });
+            if (resync) json.resync([&documents](const sjson_parse_error&) { documents.push_back("error"); });
+            json.parse(src);
+            if (!parallel.ordered) std::sort(documents.begin(), documents.end());
+            std::string out;
+            for (const auto& document : documents) out += (out.empty() ? "" : " ") + document;
+            return out;
+        }
+        // One document split into element ranges, listeners are written before it like listened()
+        inline std::string parallel_array(const std::string& src, ParallelOptions parallel) const {
+            std::string out;
+            ParallelParse json(options, parallel);
+            for (const auto& label : labels) {
+                json.listen(label, [&out, label](const JSValue& value) {
+                    out += label + "=" + value.to_string() + " ";
+                });
+            }
+            for (const auto& label : kept) json.keep(label);
+            return out + json.string(src).to_string();
+        }
+        inline void parallel(const std::string& src, const std::string& expected, ParallelOptions parallel, bool array = false) {
+            tests.parsing_total++;
+            try {
+                const auto output = array ? parallel_array(src, parallel) : this->parallel(src, parallel);
+                log(output == expected, src.size() > 64 ? src.substr(0, 64) + "..." : src, output.size() > 64 ? output.substr(0, 64) + "..." : output);
+                tests.parsing_passed += output == expected;
+            } catch (const sjson_parse_error& err) {
+                log_fail(src, err.what());
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(src, err.what());
+                tests.internal_errors++;
+            }
+        }
+        inline void parallel_error(const std::string& src, ParallelOptions parallel, bool array = false) {
+            tests.errors_total++;
+            try {
+                log_fail(src, array ? parallel_array(src, parallel) : this->parallel(src, parallel));
+            } catch (const sjson_parse_error& err) {
+                log_pass(src, err.what());
+                tests.errors_passed++;
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(src, err.what());
+                tests.internal_errors++;
+            }
+        }
+        // Tape tests read whatever they need out of the tape and write it down, then the tape is built again into a JSValue
+        inline void tape(const std::string& src, const std::string& expected, const std::function<std::string(TapeRef)>& read) {
+            tests.parsing_total++;
+            try {
+                const auto doc = Tape::string(src, options);
+                auto output = read(doc.root());
+                if (output == expected && doc.root().to_value(options).to_string() != Parse::string(src, options).to_string())
+                    output = "to_value() differs from Parse";
+                log(output == expected, src, output);
+                tests.parsing_passed += output == expected;
+            } catch (const sjson_parse_error& err) {
+                log_fail(src, err.what());
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(src, err.what());
+                tests.internal_errors++;
+            }
+        }
+        // Cache tests get the path of a source file holding src and a cache path that doesn't exist yet
+        inline void tape_cache(const std::string& src, const std::string& expected, const std::function<std::string(const std::string&, const std::string&)>& read) {
+            tests.parsing_total++;
+            const auto path = temp_path(".json");
+            const auto cache_path = temp_path(".tape");
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << src;
+            }
+            std::filesystem::remove(cache_path);
+            try {
+                const auto output = read(path.string(), cache_path.string());
+                log(output == expected, src, output);
+                tests.parsing_passed += output == expected;
+            } catch (const std::exception& err) {
+                log_fail(src, err.what());
+            }
+            std::filesystem::remove(path);
+            std::filesystem::remove(cache_path);
+        }
+        inline void cursor_error(const std::string& src, const std::function<void(Cursor&)>& read) {
+            tests.errors_total++;
+            try {
+                Cursor doc(src, options);
+                read(doc);
+                log_fail(src, "no error");
+            } catch (const sjson_parse_error& err) {
+                log_pass(src, err.what());
+                tests.errors_passed++;
+            } catch (const sjson_internal_parse_error& err) {
+                log_internal_fail(src, err.what());
+                tests.internal_errors++;
+            }
+        }
 
         inline void run() {
             section("unstrict json");
             test(R"("string\n")");
-            test(R"("string\uffff")");
+            test(R"("string\uffff")", "\"string\uffff\""); // Written back as UTF-8
             test(R"("string \"quotes\"")");
             test("1");
             test("-1");
@@ -146,6 +507,522 @@ namespace SJSON {
             test("[   1, \n 2.34,\n\n \ntrue]", "[1,2.34,true]");
             test("  {\n\n \"a\"\n:  \n2   }", "{\"a\":2}");
 
+            section("exact numbers");
+            test("0");
+            test("-0");
+            test("9007199254740993");
+            test("-9223372036854775808");
+            test("18446744073709551615");
+            test("18446744073709551616", "1.84467e+19");
+            test("[1,-2,3.5,12345678901234567]");
+            error("1e400");
+            {
+                // Built values are stored like parsed ones and reading them as a JSNumber never rounds them
+                tests.parsing_total++;
+                JSValue big = Parse::string("9007199254740993");
+                const auto rounded = big.number();
+                std::string output = std::to_string(JSValue(size_t(5)).integer()) + " " + JSValue(uint64_t(18446744073709551615u)).to_string();
+                output += " " + num_to_string(rounded) + " " + big.to_string();
+                const std::string expected = "5 18446744073709551615 9.0072e+15 9007199254740993";
+                log(output == expected, "built numbers", output);
+                tests.parsing_passed += output == expected;
+            }
+
+            section("raw numbers");
+            options.raw_numbers = true;
+            test("18446744073709551616");
+            test("-9223372036854775809");
+            test("3.14159265358979323846");
+            test("1e400");
+            test("[1.5,-1e-400,123]");
+            error("1e");
+            options.raw_numbers = false;
+
+            section("arena allocation");
+            Arena arena;
+            options.resource = &arena;
+            test(R"({"a":{"a":[[[1,[[[],[["a string long enough to not fit in small string storage"]]]],[]],["string \"quotes\""]],null],"b":[{"a":null},{"a":true}]}})");
+            test(R"(["string\n",{"key long enough to not fit in small string storage":1.5}])");
+            options.raw_numbers = true;
+            test("[18446744073709551616]");
+            options.raw_numbers = false;
+            options.resource = nullptr;
+
+            section("compact values");
+            test(R"(["","a","fourteen chars","fifteen chars!!","sixteen chars!!!"])");
+            test(R"({"long":"fourteen chars\n","short":"\n\t\""})");
+            test(R"([[1,-2,3.5,true,null,"s"],[18446744073709551615,-9223372036854775808]])");
+
+            section("object policies");
+            test(R"({"b":1,"a":2})", R"({"a":2,"b":1})");
+            options.objects = ObjectPolicy::Flat;
+            test(R"({"b":1,"a":2})");
+            test(R"({"b":1,"a":2,"b":{"d":[],"c":null}})", R"({"b":{"d":[],"c":null},"a":2})");
+            test(R"([{"y":1,"x":2},{"x":3,"y":4}])");
+            options.objects = ObjectPolicy::Hashed;
+            test(R"({"b":1,"a":2})");
+            test(R"({"k9":9,"k8":8,"k7":7,"k6":6,"k5":5,"k4":4,"k3":3,"k2":2,"k1":1,"k0":0})");
+            test(R"({"k9":9,"k8":8,"k7":7,"k6":6,"k5":5,"k4":4,"k3":3,"k2":2,"k1":1,"k0":0,"k4":{"k4":[]}})", R"({"k9":9,"k8":8,"k7":7,"k6":6,"k5":5,"k4":{"k4":[]},"k3":3,"k2":2,"k1":1,"k0":0})");
+            options.objects = ObjectPolicy::Flat;
+            {
+                // Growing the members has to move them, copies would land outside the arena
+                tests.parsing_total++;
+                std::string src = "{";
+                for (int i = 0; i < 20; i++) src += (i ? ",\"k" : "\"k") + std::to_string(i) + "\":[" + std::to_string(i) + "]";
+                src += "}";
+                Arena arena;
+                options.resource = &arena;
+                const auto value = Parse::string(src, options);
+                options.resource = nullptr;
+                int outside = 0;
+                for (const auto& [key, member] : value.object()) outside += member.array().get_allocator().resource() != &arena;
+                const auto output = std::to_string(outside) + " members outside the arena";
+                log(outside == 0, "flat members in an arena", output);
+                tests.parsing_passed += outside == 0;
+            }
+            options.objects = ObjectPolicy::Sorted;
+
+            section("interned keys");
+            options.intern_keys = true;
+            test(R"([{"b":1,"a":2},{"a":3,"b":4},{"":5,"a\"b":{"a":[]}}])", R"([{"a":2,"b":1},{"a":3,"b":4},{"":5,"a\"b":{"a":[]}}])");
+            options.objects = ObjectPolicy::Hashed;
+            test(R"([{"k9":9,"k8":8,"k7":7,"k6":6,"k5":5,"k4":4,"k3":3,"k2":2,"k1":1,"k0":0},{"k0":0,"k9":{"k9":9}}])");
+            options.objects = ObjectPolicy::Sorted;
+            labels = {"[].a", "[2][\"a\\\"b\"].a"};
+            test(R"([{"b":1,"a":2},{"a":3,"b":4},{"":5,"a\"b":{"a":[]}}])", R"([].a=2 [].a=3 [2]["a\"b"].a=[] [{"a":2,"b":1},{"a":3,"b":4},{"":5,"a\"b":{"a":[]}}])");
+            labels = {};
+            {
+                // Label keys come out of the same table, so the document's keys are the same instances
+                tests.parsing_total++;
+                KeyTable table;
+                options.keys = &table;
+                Parse json(options);
+                int calls = 0;
+                json.listen("a.b", [&calls](const JSValue&) { calls++; });
+                const auto before = table.size();
+                json.feed(R"({"a":{"b":1}})").finish();
+                options.keys = nullptr;
+                const bool passed = before == 2 && table.size() == 2 && calls == 1;
+                log(passed, "listened keys interned", std::to_string(before) + " keys before, " + std::to_string(table.size()) + " after, " + std::to_string(calls) + " calls");
+                tests.parsing_passed += passed;
+            }
+            options.intern_keys = false;
+
+            section("unicode output");
+            test(R"(["héllo wörld","日本語","😀",{"ключ":"значение"}])", R"(["héllo wörld","日本語","😀",{"ключ":"значение"}])");
+            test(R"(["\u00e9\u0001\u001f","\/ and a string long enough to be scanned a vector at a time \u00e9\t"])", R"(["é\u0001\u001f","\/ and a string long enough to be scanned a vector at a time é\t"])");
+
+            section("surrogate pairs");
+            test(R"(["\ud83d\ude00","\uD83D\uDE00 and \u00e9"])", R"(["😀","😀 and é"])");
+            test(R"(["\ud83d","\ude00","\ud83dx","\ud83d\ud83d\ude00","\ude00\ud83d"])", R"(["\ud83d","\ude00","\ud83dx","\ud83d😀","\ude00\ud83d"])");
+            options.validate_utf8 = true;
+            test(R"({"ключ":["héllo wörld and a string long enough to be checked a vector at a time","😀","\ud83d\ude00"]})", R"({"ключ":["héllo wörld and a string long enough to be checked a vector at a time","😀","😀"]})");
+            options.validate_utf8 = false;
+
+            section("deep nesting");
+            test(std::string(1000, '[') + std::string(1000, ']'));
+
+            section("listeners");
+            labels = {"a.b", "c[1]"};
+            test(R"({"a":{"b":1},"c":[1,2]})", R"(a.b=1 c[1]=2 {"a":{"b":1},"c":[1,2]})");
+            labels = {"[][]"};
+            test("[[1,2],[3]]", "[][]=1 [][]=2 [][]=3 [[1,2],[3]]");
+            labels = {"[0].x", R"(["a b"])", R"(["\u0063"])"};
+            test(R"({"0":{"x":1},"a b":true,"c":null})", R"([0].x=1 ["a b"]=true ["\u0063"]=null {"0":{"x":1},"a b":true,"c":null})");
+            labels = {"a[0][]"}; // Indexes are either all exact or all generic
+            test(R"({"a":[[1]]})");
+            labels = {".a", "a..b", "a[", "a[x]", R"(a["b")", R"(a["b"c])"}; // Malformed labels never match
+            test(R"({"a":{"b":1,"x":2}})");
+            options.drop_generics = true;
+            labels = {"c[]"};
+            test(R"({"c":[1,[2],{"d":3}]})", R"(c[]=1 c[]=[2] c[]={"d":3} {"c":[]})");
+            labels = {"c[]", "c[1]"}; // Exact listeners win and never drop
+            test(R"({"c":[1,2,3]})", "c[]=1 c[1]=2 c[]=3 {\"c\":[2]}");
+            options.drop_generics = false;
+            labels = {};
+
+            section("projection");
+            options.project = true;
+            labels = {"a.b"};
+            test(R"({"a":{"b":[1,{"c":"}"}],"x":{"y":"]\"["}},"z":[[{}],"\\"],"w":1})", R"(a.b=[1,{"c":"}"}] {"a":{"b":[1,{"c":"}"}]}})");
+            labels = {"[].id"};
+            test(R"([{"id":1,"tags":["a","b"]},{"id":2,"x":{}},{"y":[3]}])", R"([].id=1 [].id=2 [{"id":1},{"id":2},{}])");
+            labels = {"[1]"};
+            test(R"([[0],[1,[2]],"2",3])", "[1]=[1,[2]] [[1,[2]]]");
+            labels = {};
+            kept = {"a", "b[].c"};
+            test(R"({"a":{"x":[1,2]},"b":[{"c":1,"d":2},{"d":3}],"e":"f"})", R"({"a":{"x":[1,2]},"b":[{"c":1},{}]})");
+            kept = {};
+            test(R"({"a":1,"b":[1,2]})", "{}");
+            test("[1,[2],{}]", "[]");
+            test("1");
+            options.project = false;
+
+            section("events");
+            events = true;
+            test(R"({"b":1,"a":[true,null,"string\n",{}],"c":{"d":[[]]}})"); // Insertion order
+            test("1e10"); // Numbers are their source text
+            test(R"("\ud83d\ude00")", "\"\U0001f600\"");
+            test(R"({"a"1"b"2})", R"({"a":1,"b":2})");
+            test("[1 1 1]", "[1,1,1]");
+            test(R"(["a string long enough to span more than a single block of the structural index"])");
+            events = false;
+
+            section("push parsing");
+            pushed = true;
+            test(R"({"a":[1,-2.5e3,"two",{"b":null}],"c":"\u00e9\ud83d\ude00 long enough to be indexed by the structural index"})", R"({"a":[1,-2500,"two",{"b":null}],"c":"é😀 long enough to be indexed by the structural index"})");
+            error("[1,2");
+            error("1 2");
+            error(R"({"a":"b)");
+            options.project = true;
+            labels = {"a.b"};
+            test(R"({"x":["]",{"}":"\""}],"a":{"b":[1]}})", R"(a.b=[1] {"a":{"b":[1]}})");
+            labels = {};
+            options.project = false;
+            events = true;
+            test(R"({"a":[true,null,"s"],"b":{}})");
+            events = false;
+            options.drop_generics = true;
+            collect = true;
+            labels = {"[]"};
+            test(R"([1,[2],{"a":3}])", R"(1 [2] {"a":3} [])");
+            pushed = false;
+            test(R"([1,[2],{"a":3}])", R"(1 [2] {"a":3} [])"); // Streams are pulled by values()
+            labels = {};
+            collect = false;
+            options.drop_generics = false;
+
+            section("multiple documents");
+            options.multi_document = true;
+            labels = {""};
+            test("1 2\n{\"a\":[3]}[4]\n", R"(=1 =2 ={"a":[3]} =[4] [4])");
+            test("\n", "null");
+            error("[1]\n[2");
+            error("[1]\n]");
+            resync = true;
+            test("{\"a\":1}\n{\"a\":}\n[2]\n", R"(={"a":1} error =[2] [2])");
+            test("1\n@\n\"s\"", R"(=1 error ="s" "s")");
+            test("[1]\n[2", "=[1] error null");
+            resync = false;
+            labels = {};
+            options.multi_document = false;
+
+            section("parallel documents");
+            {
+                parallel("1\n2\n[3]\n{\"a\":4}\n\"5\"", R"(1 2 [3] {"a":4} "5")", {.threads = 3, .batch_size = 1, .window = 2});
+                std::string lines, expected;
+                std::vector<std::string> sorted;
+                for (int i = 0; i < 1000; i++) {
+                    lines += "[" + std::to_string(i) + "]\n";
+                    expected += (i ? " [" : "[") + std::to_string(i) + "]";
+                    sorted.push_back("[" + std::to_string(i) + "]");
+                }
+                parallel(lines, expected, {.threads = 4, .batch_size = 16, .window = 3});
+                std::sort(sorted.begin(), sorted.end());
+                std::string unordered;
+                for (const auto& document : sorted) unordered += (unordered.empty() ? "" : " ") + document;
+                parallel(lines, unordered, {.threads = 4, .batch_size = 16, .ordered = false});
+                parallel_error("1\n[2\n3\n", {.threads = 2, .batch_size = 1}); // Documents can't span batches
+                parallel_error("1\n2\n}\n", {.threads = 2, .batch_size = 1, .ordered = false});
+                resync = true;
+                parallel("1\n{\"a\":}\n3\n[4", "1 error 3 error", {.threads = 2, .batch_size = 1});
+                resync = false;
+            }
+
+            section("parallel arrays");
+            {
+                const ParallelOptions small {.threads = 3, .batch_size = 1, .window = 2};
+                parallel(R"( [1, [2], {"a":3}, "4" ,,5 ] )", R"([1,[2],{"a":3},"4",5])", small, true);
+                parallel("[]", "[]", small, true);
+                std::string big = "[";
+                for (int i = 0; i < 1000; i++) big += (i ? ",{\"id\":" : "{\"id\":") + std::to_string(i) + R"(,"s":"x,]\"}[{"})";
+                big += "]";
+                parallel(big, Parse::string(big).to_string(), {.threads = 4, .batch_size = 64}, true);
+                labels = {"[3]"}; // Indexes carry on across ranges
+                parallel("[0,1,2,3,4,5]", "[3]=3 [0,1,2,3,4,5]", small, true);
+                labels = {"a[]"};
+                parallel(R"({"a":[1,2]})", R"(a[]=1 a[]=2 {"a":[1,2]})", small, true); // Anything but an array is parsed whole
+                options.drop_generics = true;
+                labels = {"[]"};
+                parallel("[1,[2],{}]", "[]=1 []=[2] []={} []", small, true);
+                options.drop_generics = false;
+                options.project = true;
+                labels = {"[].id"};
+                parallel(R"([{"id":1,"x":[1]},{"y":2,"id":2}])", R"([].id=1 [].id=2 [{"id":1},{"id":2}])", small, true);
+                options.project = false;
+                labels = {};
+                parallel_error("[1,2", small, true);
+                parallel_error("[1]x", small, true);
+                parallel_error("[1:2]", small, true);
+                parallel_error("[{]", small, true);
+                parallel_error("[1,{\"a\"", small, true);
+            }
+
+            section("mapped files");
+            mapped = true;
+            {
+                std::string big = "[";
+                for (int i = 0; i < 500; i++) big += (i ? ",{\"id\":" : "{\"id\":") + std::to_string(i) + R"(,"s":"spans pages"})";
+                big += "]";
+                test(big, Parse::string(big).to_string()); // Pieces end mid token
+                labels = {"[499].id"};
+                test(big, "[499].id=499 " + Parse::string(big).to_string());
+                labels = {};
+                error(big.substr(0, big.size() - 1));
+                test(R"({"a":1})");
+            }
+            mapped = false;
+
+            section("read-ahead");
+            read_ahead = true;
+            test(R"({"a":[1,-2.5e3,"two",{"b":null}],"c":"\u00e9 split across buffers"})", R"({"a":[1,-2500,"two",{"b":null}],"c":"é split across buffers"})");
+            labels = {"a[]"};
+            test(R"({"a":[1,[2]]})", R"(a[]=1 a[]=[2] {"a":[1,[2]]})");
+            labels = {};
+            error("[1,2");
+            error(R"({"a":"b)");
+            read_ahead = false;
+            {
+                // Errors thrown by the reader come out of the parse after everything read before them
+                tests.errors_total++;
+                try {
+                    ReadAhead input([calls = 0](char* data, size_t) mutable -> size_t {
+                        if (calls++) throw sjson_parse_error::unexpected_eof();
+                        data[0] = '[';
+                        return 1;
+                    });
+                    Parse json;
+                    json.feed(input).finish();
+                    log_fail("reader error", json.to_string());
+                } catch (const sjson_parse_error& err) {
+                    log_pass("reader error", err.what());
+                    tests.errors_passed++;
+                }
+            }
+
+            section("gzip");
+            gzipped = true;
+            test(R"({"a":[1,-2.5e3,"two",{"b":null}],"c":"\u00e9 inflated a few bytes at a time"})", R"({"a":[1,-2500,"two",{"b":null}],"c":"é inflated a few bytes at a time"})");
+            labels = {"a[]"};
+            test(R"({"a":[1,[2]]})", R"(a[]=1 a[]=[2] {"a":[1,[2]]})");
+            labels = {};
+            error("[1,2");
+            gzipped = false;
+            {
+                // Concatenated members are one stream, like appending to a .gz log
+                tests.parsing_total++;
+                options.multi_document = true;
+                labels = {""};
+                const auto output = inflated(gzip("[1]\n") + gzip("[2]\n"));
+                log(output == "=[1] =[2] [2]", "gzip members", output);
+                tests.parsing_passed += output == "=[1] =[2] [2]";
+                labels = {};
+                options.multi_document = false;
+                tests.parsing_total++;
+                const auto compressed = gzip("[\"through a stream\"]");
+                const auto streamed = Parse::stream(gzip_stream(pieces(compressed), 4)).to_string();
+                log(streamed == "[\"through a stream\"]", "gzip stream", streamed);
+                tests.parsing_passed += streamed == "[\"through a stream\"]";
+                // Not parse errors, so they're just checked
+                for (const auto& broken : {compressed.substr(0, compressed.size() / 2), "not gzip at all" + compressed}) {
+                    tests.errors_total++;
+                    try {
+                        log_fail("broken gzip", inflated(broken));
+                    } catch (const std::runtime_error& err) {
+                        log_pass("broken gzip", err.what());
+                        tests.errors_passed++;
+                    }
+                }
+            }
+
+            section("cbor");
+            binary = true;
+            options.format = Format::CBOR;
+            test(R"({"a":[0,23,24,-1,-25,65536,-9223372036854775808,18446744073709551615,2.5,0.1,1e300,"two",{"b":null}],"c":true,"d":false,"\u00e9":"long enough to need a length byte"})", R"({"a":[0,23,24,-1,-25,65536,-9223372036854775808,18446744073709551615,2.5,0.1,1e+300,"two",{"b":null}],"c":true,"d":false,"é":"long enough to need a length byte"})");
+            test("[[],{},\"\"]");
+            test(std::string(5000, '[') + std::string(5000, ']'));
+            labels = {"a[]", "b"};
+            test(R"({"a":[1,[2]],"b":{"c":3}})", R"(a[]=1 a[]=[2] b={"c":3} {"a":[1,[2]],"b":{"c":3}})");
+            options.drop_generics = true;
+            test(R"({"a":[1,[2],3]})", R"(a[]=1 a[]=[2] a[]=3 {"a":[]})");
+            options.drop_generics = false;
+            options.project = true;
+            labels = {"a.b"};
+            test(R"({"x":[{"y":[1]}],"a":{"b":[1],"c":{}}})", R"(a.b=[1] {"a":{"b":[1]}})");
+            labels = {"[].id"};
+            test(R"([{"id":1,"x":[1]},{"y":{"z":2},"id":2}])", R"([].id=1 [].id=2 [{"id":1},{"id":2}])");
+            options.project = false;
+            labels = {};
+            binary = false;
+            // From RFC 8949's examples, indefinite lengths, half floats and tags
+            decoded("\x9f\x01\x82\x02\x03\x9f\x04\x05\xff\xff", "[1,[2,3],[4,5]]");
+            decoded("\xbf\x61\x61\x01\x61\x62\x9f\x02\x03\xff\xff", R"({"a":1,"b":[2,3]})");
+            decoded(std::string("\x83\xf9\x3c\x00\xf9\xc4\x00\xf7", 8), "[1,-4,null]");
+            decoded("\xc1\x1a\x51\x4b\x67\xb0", "1363896240");
+            decoded("\x3b\xff\xff\xff\xff\xff\xff\xff\xff", "-1.84467e+19");
+            options.raw_numbers = true;
+            decoded("\x3b\xff\xff\xff\xff\xff\xff\xff\xff", "-18446744073709551616");
+            options.raw_numbers = false;
+            options.multi_document = true;
+            labels = {""};
+            decoded(std::string("\x01\x81\x02\xa0", 4), "=1 =[2] ={} {}"); // CBOR sequences
+            labels = {};
+            options.multi_document = false;
+            decoded_error("\x82\x01");
+            decoded_error("\x62\x61");
+            decoded_error("\x01\x02");
+            decoded_error("\xff");
+            decoded_error("\x82\x01\xff");
+            decoded_error("\xbf\x61\x61\xff");
+            decoded_error("\xa1\x01\x02");
+            decoded_error("\x41\x61");
+            decoded_error("\x7f\x61\x61\xff");
+            decoded_error("\x1c");
+            options.validate_utf8 = true;
+            decoded_error("\x61\xff");
+            options.validate_utf8 = false;
+            options.format = Format::JSON;
+
+            section("cursor");
+            cursor(R"({"id":42,"name":"sjson","tags":["a","b"],"nested":{"x":1.5,"y":[true,false,null]}})", "42 true false null sjson", [](Cursor& doc) {
+                auto object = doc.root().get_object();
+                auto out = std::to_string(object["id"].get_int64());
+                for (auto value : object["nested"].get_object()["y"].get_array())
+                    out += value.is_null() ? " null" : value.get_bool() ? " true" : " false";
+                return out + " " + std::string(object["name"].get_string_view()); // Wraps around
+            });
+            cursor(R"({"a":{"deep":[1,[2,{"q":"}"}]]},"b":"x\"y","c":-7})", R"(-7 x"y missing)", [](Cursor& doc) {
+                auto object = doc.root().get_object();
+                auto out = std::to_string(object["c"].get_int64());
+                out += " " + std::string(object["b"].get_string_view());
+                return out + (object.find("d") ? " found" : " missing");
+            });
+            cursor(R"({"k1":1,"k2":[1,2],"k3":"v"})", "k1=1 k2=1 k3=v", [](Cursor& doc) {
+                std::string out;
+                for (auto [key, value] : doc.root().get_object()) {
+                    out += (out.empty() ? "" : " ") + std::string(key) + "=";
+                    if (value.type() == JSValueType::Array)
+                        out += std::to_string((*value.get_array().begin()).get_int64()); // The rest is skipped
+                    else if (value.type() == JSValueType::String)
+                        out += value.get_string_view();
+                    else
+                        out += std::to_string(value.get_int64());
+                }
+                return out;
+            });
+            cursor(R"([{"a":1},  [2 ,3],"s"])", R"({"a":1} [2,3] s)", [](Cursor& doc) {
+                auto array = doc.root().get_array();
+                CursorValue value;
+                array.next(value);
+                std::string out(value.raw());
+                array.next(value);
+                out += " " + value.to_value().to_string();
+                array.next(value);
+                return out + " " + std::string(value.get_string_view());
+            });
+            cursor("[18446744073709551615, 1e3]", "18446744073709551615 1000", [](Cursor& doc) {
+                auto array = doc.root().get_array();
+                auto it = array.begin();
+                auto out = std::to_string((*it).get_uint64());
+                return out + " " + num_to_string((*++it).get_double());
+            });
+            cursor(R"({"a":1,"b":2})", "2 2 1 1 missing", [](Cursor& doc) {
+                auto object = doc.root().get_object();
+                auto out = std::to_string(object["b"].get_int64());
+                out += " " + std::to_string(object["b"].get_int64()); // Same member again
+                auto a = object.find("a");
+                out += " " + std::to_string(a->get_int64());
+                a = object.find("a");
+                out += a ? " " + std::to_string(a->get_int64()) : " not found";
+                return out + (object.find("c") ? " found" : " missing");
+            });
+            cursor(R"({"a" 1 "b":2})", "2", [](Cursor& doc) { return std::to_string(doc.root().get_object()["b"].get_int64()); });
+            cursor("[1 2,,3]", "123", [](Cursor& doc) {
+                std::string out;
+                for (auto value : doc.root().get_array()) out += std::to_string(value.get_int64());
+                return out + (doc.at_end() ? "" : " not at end");
+            });
+
+            section("tape");
+            taped = true;
+            test(R"({"b":1,"a":[true,null,"string\n",{}],"c":{"d":[[]]}})"); // Insertion order
+            test(R"([1,-2,3.5,1e10,18446744073709551615,-9223372036854775808,18446744073709551616,"\ud83d\ude00"])", R"([1,-2,3.5,1e+10,18446744073709551615,-9223372036854775808,1.84467e+19,"😀"])");
+            test(R"({"a"1"b"2})", R"({"a":1,"b":2})");
+            test(std::string(5000, '[') + std::string(5000, ']'));
+            options.raw_numbers = true;
+            test("[18446744073709551616,3.14159265358979323846]");
+            options.raw_numbers = false;
+            taped = false;
+            tape(R"({"id":42,"tags":["a","b"],"nested":{"x":1.5,"y":[true,false,null]},"id":7})", "42 2 a,b 1.5 true false null 3", [](TapeRef doc) {
+                const auto object = doc.object();
+                auto out = std::to_string(object["id"].integer()); // First of the duplicates
+                out += " " + std::to_string(object["tags"].array().size()) + " ";
+                for (auto tag : object["tags"].array()) out += std::string(tag.string_view()) + (tag.string_view() == "b" ? "" : ",");
+                const auto nested = object.at("nested").object();
+                out += " " + num_to_string(nested["x"].number());
+                for (auto value : nested["y"].array()) out += value.is_null() ? " null" : value.boolean() ? " true" : " false";
+                return out + " " + std::to_string(object.size() - object.count("id") + 1);
+            });
+            tape(R"([{"a":1},[2,[3]],"s",{}])", R"(4 [2,[3]] s empty missing)", [](TapeRef doc) {
+                const auto array = doc.array();
+                auto out = std::to_string(array.size()) + " " + array[1].to_string() + " " + std::string(array.at(2).string_view());
+                out += array[3].object().empty() ? " empty" : " not empty";
+                return out + (array[0].object().contains("b") ? " found" : " missing");
+            });
+            tape(R"([1,"x"])", "bad type bad type out of range", [](TapeRef doc) {
+                std::string out;
+                try {
+                    doc.array()[1].integer();
+                } catch (const std::bad_variant_access&) { out += "bad type"; }
+                try {
+                    doc.object();
+                } catch (const std::bad_variant_access&) { out += " bad type"; }
+                try {
+                    doc.array().at(2);
+                } catch (const std::out_of_range&) { out += " out of range"; }
+                return out;
+            });
+
+            section("tape cache");
+            taped = cached = true;
+            test(R"({"b":1,"a":[true,null,"string\n",{}],"c":{"d":[[]]}})");
+            test(R"([1,-2,3.5,18446744073709551615,"a string long enough to not fit in small string storage"])");
+            test("1");
+            taped = cached = false;
+            tape_cache(R"({"a":[1,2]})", "built mapped mapped rebuilt mapped rebuilt rebuilt rebuilt [1,2,3] mapped", [](const std::string& src, const std::string& cache) {
+                std::string out;
+                const auto step = [&out](const CachedTape& tape) { out += tape.rebuilt() ? "rebuilt " : "mapped "; };
+                out += CachedTape::open(src, cache).rebuilt() ? "built " : "not built ";
+                step(CachedTape::open(src, cache));
+                step(CachedTape::open(src, cache, {}, false)); // Same size and modification time
+                step(CachedTape::open(src, cache, {.validate_utf8 = true})); // Not validated before
+                step(CachedTape::open(src, cache)); // Validated is good enough
+                step(CachedTape::open(src, cache, {.raw_numbers = true})); // Different entries
+                {
+                    std::ofstream(src, std::ios::binary | std::ios::trunc) << "[1,2,3]";
+                }
+                step(CachedTape::open(src, cache));
+                {
+                    std::ofstream(cache, std::ios::binary | std::ios::trunc) << "SJSONTAP and not much else";
+                }
+                step(CachedTape::open(src, cache));
+                const auto tape = CachedTape::open(src, cache);
+                out += tape.to_string() + (tape.rebuilt() ? " rebuilt" : " mapped");
+                return out;
+            });
+            tape_cache(R"({"a":[1,2]})", R"(mapped mapped {"a":[1,2]})", [](const std::string& src, const std::string& cache) {
+                CachedTape::save(cache, Tape::file(src), src);
+                std::string out = CachedTape::open(src, cache, {}, false).rebuilt() ? "rebuilt " : "mapped "; // Same modification time
+                const auto tape = CachedTape::open(src, cache);
+                return out + (tape.rebuilt() ? "rebuilt " : "mapped ") + tape.to_string();
+            });
+
+            section("indexed chunks");
+            test(R"(["a string long enough to span more than a single block of the structural index"])");
+            test(R"({"key with spaces and \"quotes\" that keeps going past one block":"value\\with\tescapes"})");
+            test("[\n\n                                                                        1,\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t2]", "[1,2]");
+            error(R"(["a string long enough to span more than a single block but never ends])");
+
             section("invalid token errors");
             error("[test]");
             error(R"({"a":truey})");
@@ -215,6 +1092,64 @@ namespace SJSON {
             error(R"({"a":1,,"b":2})");
             error(R"({"a":1,  ,"b":2})");
 
+            section("projection errors");
+            options.project = true;
+            labels = {"b"};
+            error(R"({"a":[1,2)");
+            error(R"({"a":"string)");
+            error(R"({"a":{"b":1})");
+            error(R"([[1,2],)");
+            error(R"({"a":})");
+            error(R"({"a":,"b":1})");
+            error(R"({"a": ,"b":1})");
+            error(R"({"a":1:2,"b":3})");
+            labels = {};
+            options.project = false;
+
+            section("events errors");
+            events = true;
+            error("[1,2");
+            error(R"({"a"})");
+            error("{1:2}");
+            error("[}]");
+            error("[1e999]");
+            error("[]1");
+            error(R"(["string)");
+            events = false;
+
+            section("tape errors");
+            taped = true;
+            error("[1,2");
+            error(R"({"a"})");
+            error("[1e999]");
+            error("[]1");
+            taped = false;
+
+            section("cursor errors");
+            cursor_error(R"({"a":"x"})", [](Cursor& doc) { doc.root().get_object()["a"].get_int64(); });
+            cursor_error(R"({"a":1.5})", [](Cursor& doc) { doc.root().get_object()["a"].get_int64(); });
+            cursor_error("[1,2", [](Cursor& doc) { doc.root().get_array().skip(); });
+            cursor_error("[1:2]", [](Cursor& doc) {
+                for (auto value : doc.root().get_array()) value.get_int64();
+            });
+            cursor_error(R"({"a":})", [](Cursor& doc) { doc.root().get_object().skip(); });
+            cursor_error(R"({"a":[1,{"b":"]})", [](Cursor& doc) { doc.root().get_object().skip(); });
+            cursor_error(R"({"a":1})", [](Cursor& doc) {
+                auto value = doc.root().get_object()["a"];
+                value.get_int64();
+                value.get_int64(); // Already read
+            });
+
+            section("utf-8 validation errors");
+            options.validate_utf8 = true;
+            error("[\"\xff\"]");
+            error("[\"\xc3\"]");
+            error("[\"\xed\xa0\x80\"]");
+            error("[\"a string long enough to be checked a vector at a time \xe0\x80\xaf\"]");
+            error(R"(["\ud83d"])");
+            error(R"({"\ude00":1})");
+            options.validate_utf8 = false;
+
             std::cout << "[RESULT] Passed " << (tests.parsing_passed + tests.errors_passed) << '/' << (tests.parsing_total + tests.errors_total) << " tests\n"
                       << "[RESULT] Passed " << tests.parsing_passed << '/' << tests.parsing_total << " parsing tests\n"
                       << "[RESULT] Passed " << tests.errors_passed << '/' << tests.errors_total << " errors tests\n"
@@ -1,12 +1,44 @@
 #include "token.hpp"
 #include "syntax.hpp"
 #include "util.hpp"
+#include <charconv>
 
 namespace SJSON {
+    namespace {
+        // Which kind of token each lexer state belongs to
+        constexpr TokenType token_types[lex_state_count] {
+            TokenType::Unresolved,
+            TokenType::Operator,
+            TokenType::Keyword,
+            TokenType::Number,
+            TokenType::Number,
+            TokenType::String,
+            TokenType::String,
+            TokenType::String,
+            TokenType::String,
+        };
+    } // namespace
+
     Token::Token() {
         reset();
     }
 
+    // Grow the view if the token still lives in its chunk
+    void Token::append(const char* c) {
+        if (owned)
+            buffer += *c;
+        else if (span.empty())
+            span = std::string_view(c, 1);
+        else
+            span = std::string_view(span.data(), span.size() + 1);
+    }
+    // Switch to the owned buffer for text that's escaped or outlives its chunk
+    void Token::own() {
+        if (owned) return;
+        buffer.assign(span);
+        owned = true;
+    }
+
     // Parsing shit
     bool Token::is_operator() const noexcept {
         return type == TokenType::Operator;
@@ -17,125 +49,134 @@ namespace SJSON {
     bool Token::is_value() const noexcept {
         return !is_operator() && !is_unresolved();
     }
+    // Inside a string where only quotes and escapes change the state
+    bool Token::is_string_body() const noexcept {
+        return state == LexState::String;
+    }
     void Token::reset() {
-        escape_state = EscapeState::None;
+        state = LexState::Unresolved;
         escape_sequence = "";
+        high_surrogate = 0;
+        high_surrogate_end = 0;
+        buffer.clear();
+        span = {};
+        owned = false;
         type = TokenType::Unresolved;
-        src = "";
     }
-    void Token::push(char c) {
-        if (is_terminating(c))
-            throw sjson_internal_parse_error::invalid_continued_read();
-        switch (type) {
-            case TokenType::Unresolved: {
-                if (whitespace_set.contains(c)) return; // Only ignore whitespace if it doesn't matter to the token
-                src += c;
-                if (operator_map.count(c)) {
-                    type = TokenType::Operator;
-                } else if (decimals_set.contains(c)) {
-                    type = TokenType::Number;
-                } else if (letters_set.contains(c)) {
-                    type = TokenType::Keyword;
-                } else if (c == string_char) {
-                    type = TokenType::String;
+    bool Token::consume(const char* at) {
+        const char c = *at;
+        const auto transition = lex_transition(state, c);
+        switch (transition.action) {
+            case LexAction::Error: throw sjson_parse_error::unexpected_character(c);
+            case LexAction::Terminate: return false;
+            case LexAction::Skip: break;
+            case LexAction::Append: append(at); break;
+            case LexAction::Escape: own(); break; // Escaped text differs from the source text
+            case LexAction::Unescape: buffer += unescape_table[uint8_t(c)]; break;
+            case LexAction::Hex: {
+                escape_sequence += c;
+                if (escape_sequence.size() != sequence_escape_len) return true;
+                if (!is_valid_integer(escape_sequence, 16))
+                    throw sjson_parse_error::invalid_escape(escape_sequence);
+                uint16_t unit = 0;
+                std::from_chars(escape_sequence.data(), escape_sequence.data() + escape_sequence.size(), unit, 16);
+                if (is_low_surrogate(unit) && high_surrogate && high_surrogate_end == buffer.size()) {
+                    // Replace the high surrogate written by the escape right before this one with the whole code point
+                    buffer.resize(buffer.size() - 3);
+                    utf8_encode(buffer, combine_surrogates(high_surrogate, unit));
+                    high_surrogate = 0;
                 } else {
-                    throw sjson_parse_error::unexpected_character(c);
-                }
-                return;
-            }
-            case TokenType::Operator:
-            case TokenType::Keyword:
-            case TokenType::Number: {
-                src += c;
-                return;
-            }
-            case TokenType::String: {
-                switch (escape_state) {
-                    case EscapeState::None: {
-                        if (c == escape_char) {
-                            escape_state = EscapeState::Escaping;
-                            return;
-                        }
-                        if (c == string_char)
-                            escape_state = EscapeState::End;
-                        src += c;
-                        return;
-                    }
-                    case EscapeState::End:
-                        throw sjson_internal_parse_error::invalid_escape_state("token.push(char) -> (string has already finished lexing)");
-                    case EscapeState::Escaping: {
-                        if (c == sequence_escape_char) {
-                            escape_state = EscapeState::Sequence;
-                        } else {
-                            src += escape_map.contains(c) ? escape_map.at(c) : c;
-                            escape_state = EscapeState::None;
-                        }
-                        return;
-                    }
-                    case EscapeState::Sequence: {
-                        escape_sequence += c;
-                        if (escape_sequence.size() != sequence_escape_len) return;
-                        if (!is_valid_integer(escape_sequence, 16))
-                            throw sjson_parse_error::invalid_escape(escape_sequence);
-                        src += hex_to_UTF8(escape_sequence);
-                        escape_state = EscapeState::None;
-                        escape_sequence = "";
-                        return;
-                    }
+                    // Lone surrogates are kept encoded like any other code point (WTF-8) so they can be written back
+                    utf8_encode(buffer, unit);
+                    high_surrogate = is_high_surrogate(unit) ? unit : 0;
+                    high_surrogate_end = buffer.size();
                 }
-                throw sjson_internal_parse_error::invalid_escape_state("token.push(char)");
+                escape_sequence = "";
+                state = LexState::String;
+                return true;
             }
         }
-        throw sjson_internal_parse_error::invalid_token_type("token.push(char)");
+        state = transition.next;
+        type = token_types[size_t(state)];
+        return true;
+    }
+    void Token::push(const char* at) {
+        if (!consume(at))
+            throw sjson_internal_parse_error::invalid_continued_read();
+    }
+    void Token::push(const char* begin, size_t length) {
+        if (!is_string_body())
+            throw sjson_internal_parse_error::invalid_token_type("token.push(const char*, size_t)");
+        if (owned)
+            buffer.append(begin, length);
+        else
+            span = std::string_view(span.data(), span.size() + length);
+    }
+    // Characters that don't live in a chunk always go to the owned buffer
+    void Token::push(char c) {
+        own();
+        push(&c);
+    }
+    void Token::detach() {
+        if (!is_unresolved()) own();
     }
     // For end of file
     bool Token::is_terminating() const {
-        switch (type) {
-            case TokenType::Unresolved: return false;
-            case TokenType::Operator: return true;
-            case TokenType::Keyword: return true;
-            case TokenType::Number: return true;
-            case TokenType::String: return true;
-        }
-        throw sjson_internal_parse_error::invalid_token_type("token.is_terminating()");
+        return state != LexState::Unresolved;
     }
     bool Token::is_terminating(char c) const {
-        switch (type) {
-            case TokenType::Unresolved: return false;
-            case TokenType::Operator: return true;
-            case TokenType::Keyword: return !letters_set.contains(c) || whitespace_set.contains(c);
-            case TokenType::Number: return (!decimals_set.contains(c) && !special_numbers_set.contains(c)) || whitespace_set.contains(c);
-            // String termination doesn't depend on the proceeding character
-            case TokenType::String: return escape_state == EscapeState::End;
-        }
-        throw sjson_internal_parse_error::invalid_token_type("token.is_terminating(char)");
+        return lex_transition(state, c).action == LexAction::Terminate;
     }
     Token Token::copy() const {
         return Token(*this);
     }
+    std::string_view Token::src() const noexcept {
+        return owned ? std::string_view(buffer) : span;
+    }
 
     // Value shit
     Operators Token::to_operator() const {
-        if (src.size() != 1 || !operator_map.count(src[0])) // All operators are one character
-            throw sjson_parse_error::invalid_token("operator", src);
-        return operator_map.at(src[0]);
+        const auto text = src();
+        if (text.size() != 1 || !SJSON::is_operator(text[0])) // All operators are one character
+            throw sjson_parse_error::invalid_token("operator", text);
+        return operator_table[uint8_t(text[0])];
     }
     Keywords Token::to_keyword() const {
-        if (!keyword_map.count(src))
-            throw sjson_parse_error::invalid_token("keyword", src);
-        return keyword_map.at(src);
+        const auto text = src();
+        const auto keyword = find_keyword(text);
+        if (!keyword)
+            throw sjson_parse_error::invalid_token("keyword", text);
+        return *keyword;
+    }
+    JSValue Token::to_number(const ParseOptions& options) const {
+        const auto text = src();
+        const auto number = parse_number(text, options.raw_numbers);
+        switch (number.kind) {
+            case NumberKind::Integer: return JSValue(JSInteger(number.integer));
+            case NumberKind::Unsigned: return JSValue(JSUnsigned(number.uinteger));
+            case NumberKind::Double: return JSValue(number.number);
+            case NumberKind::Raw: return JSValue(JSRawNumber {JSString(text, options.memory())});
+        }
+        throw sjson_internal_parse_error::invalid_token_type("token.to_number()");
     }
-    JSNumber Token::to_number() const {
-        if (!is_valid_number(src))
-            throw sjson_parse_error::invalid_token("number", src);
-        return std::stod(src);
+    std::string_view Token::number_src(const ParseOptions& options) const {
+        const auto text = src();
+        parse_number(text, options.raw_numbers);
+        return text;
     }
-    JSString Token::to_string() const {
-        if (escape_state != EscapeState::End)
+    std::string_view Token::string_body(bool validate_utf8) const {
+        if (state != LexState::End)
             throw sjson_parse_error::unexpected_eof();
-        return src.substr(1, src.size() - 2); // Remove preceding and proceeding string chars cuz everything is already escaped
+        const auto text = src();
+        const auto body = text.substr(1, text.size() - 2); // Remove preceding and proceeding string chars cuz everything is already escaped
+        if (validate_utf8 && !is_valid_utf8(body))
+            throw sjson_parse_error::invalid_utf8(jsstring_escape(body));
+        return body;
+    }
+    JSString Token::to_string(std::pmr::memory_resource* resource) const {
+        return JSString(string_body(), resource);
     }
-    JSValue Token::to_value() const {
+    JSValue Token::to_value(const ParseOptions& options) const {
         switch (type) {
             case TokenType::Unresolved: throw sjson_internal_parse_error::invalid_token_eval();
             case TokenType::Operator: throw sjson_internal_parse_error::invalid_token_eval();
@@ -147,8 +188,8 @@ namespace SJSON {
                 }
                 break;
             }
-            case TokenType::Number: return JSValue(to_number());
-            case TokenType::String: return JSValue(to_string());
+            case TokenType::Number: return to_number(options);
+            case TokenType::String: return JSValue(string_body(options.validate_utf8), options.memory());
         }
         throw sjson_internal_parse_error::invalid_token_type("token.to_value()");
     }
@@ -165,6 +206,6 @@ namespace SJSON {
         throw sjson_internal_parse_error::invalid_token_type("token.type_to_str()");
     }
     std::string Token::to_debug() const {
-        return std::string(type_to_str()) + "<" + src + ">";
+        return std::string(type_to_str()) + "<" + std::string(src()) + ">";
     }
 } // namespace SJSON
@@ -1,7 +1,10 @@
 #pragma once
+#include "options.hpp"
 #include "syntax.hpp"
 #include "value.hpp"
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace SJSON {
     enum class TokenType {
@@ -14,12 +17,19 @@ namespace SJSON {
 
     class Token {
     protected:
-        EscapeState escape_state;
+        LexState state;
         std::string escape_sequence;
+        char16_t high_surrogate; // Last \uXXXX if it started a surrogate pair
+        size_t high_surrogate_end; // Where it ended in the buffer, the pair only combines if nothing came after it
+        std::string buffer; // Only used once the token can't be a view into its chunk
+        std::string_view span;
+        bool owned;
+
+        void append(const char* c);
+        void own();
 
     public:
         TokenType type;
-        std::string src;
 
         Token();
         Token(const Token& token) = default;
@@ -32,18 +42,26 @@ namespace SJSON {
         bool is_operator() const noexcept;
         bool is_unresolved() const noexcept;
         bool is_value() const noexcept;
+        bool is_string_body() const noexcept;
         void reset();
+        bool consume(const char* c); // False if the character belongs to the next token
+        void push(const char* c); // For characters that stay alive in the chunk
+        void push(const char* begin, size_t length); // For runs of string contents without quotes or escapes
         void push(char c);
+        void detach(); // For tokens that straddle chunks
         bool is_terminating() const; // For end of file
         bool is_terminating(char c) const;
         Token copy() const;
+        std::string_view src() const noexcept;
 
         // Value shit
         Operators to_operator() const;
         Keywords to_keyword() const;
-        JSNumber to_number() const;
-        JSString to_string() const;
-        JSValue to_value() const;
+        JSValue to_number(const ParseOptions& options = {}) const;
+        std::string_view number_src(const ParseOptions& options = {}) const; // Validated like to_number without building the value
+        std::string_view string_body(bool validate_utf8 = false) const; // Contents of a finished string token without its quotes
+        JSString to_string(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+        JSValue to_value(const ParseOptions& options = {}) const;
 
         // Debug shit
         const char* type_to_str() const;
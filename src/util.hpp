@@ -1,70 +1,226 @@
 #pragma once
+#include "simd.hpp"
 #include "syntax.hpp"
 #include <charconv>
 #include <cstddef>
 #include <cstdint>
-#include <format>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace SJSON {
-    inline std::string jschar_escape(char c) {
-        // If an escape sequence is needed for ts char
-        for (const auto& [k, v] : escape_map)
-            if (v == c) return std::string {'\\', k};
-        // If this char is displayable
-        if (c >= 32 && c <= 126) return std::string {c};
-        return ""; // Can't escape cuz this char needs a multiescape
-    }
-    inline std::string jschar_multiescape(char a, char b) {
-        return std::format("\\u{:02x}{:02x}", static_cast<uint8_t>(a), static_cast<uint8_t>(b));
-    }
-    inline std::string jschar_multiescape(char b) {
-        return jschar_multiescape(0, b);
-    }
-    inline std::string jsstring_escape(const std::string& src) {
-        std::string out = "\"";
+    inline constexpr bool is_high_surrogate(char32_t c) noexcept {
+        return c >= 0xd800 && c <= 0xdbff;
+    }
+    inline constexpr bool is_low_surrogate(char32_t c) noexcept {
+        return c >= 0xdc00 && c <= 0xdfff;
+    }
+    inline constexpr char32_t combine_surrogates(char32_t high, char32_t low) noexcept {
+        return 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00);
+    }
+    // Decodes one UTF-8 sequence, returns its length or 0 if it's invalid (overlong, a surrogate or past U+10FFFF)
+    inline size_t utf8_decode(std::string_view src, char32_t& out) noexcept {
+        if (src.empty()) return 0;
+        const auto lead = uint8_t(src[0]);
+        if (lead < 0x80) {
+            out = lead;
+            return 1;
+        }
+        size_t length;
+        char32_t min;
+        if ((lead & 0xe0) == 0xc0) {
+            length = 2, min = 0x80, out = lead & 0x1f;
+        } else if ((lead & 0xf0) == 0xe0) {
+            length = 3, min = 0x800, out = lead & 0x0f;
+        } else if ((lead & 0xf8) == 0xf0) {
+            length = 4, min = 0x10000, out = lead & 0x07;
+        } else {
+            return 0;
+        }
+        if (src.size() < length) return 0;
+        for (size_t i = 1; i < length; i++) {
+            const auto c = uint8_t(src[i]);
+            if ((c & 0xc0) != 0x80) return 0;
+            out = (out << 6) | (c & 0x3f);
+        }
+        if (out < min || out > 0x10ffff || (out >= 0xd800 && out <= 0xdfff)) return 0;
+        return length;
+    }
+    // Length of a lone surrogate kept as WTF-8 at the start of src, 0 if there isn't one
+    inline size_t wtf8_surrogate(std::string_view src, char32_t& out) noexcept {
+        if (src.size() < 3 || uint8_t(src[0]) != 0xed || (uint8_t(src[1]) & 0xe0) != 0xa0 || (uint8_t(src[2]) & 0xc0) != 0x80) return 0;
+        out = 0xd000 | ((uint8_t(src[1]) & 0x3f) << 6) | (uint8_t(src[2]) & 0x3f);
+        return 3;
+    }
+    // Non-ASCII bytes are decoded one sequence at a time, everything else is skipped a vector at a time
+    inline bool is_valid_utf8(std::string_view src) noexcept {
         for (size_t i = 0; i < src.size();) {
-            if (auto esc = jschar_escape(src[i]); esc.size()) {
-                // If single char escape
-                out += esc;
-                i++;
-            } else if (i + 1 == src.size()) {
-                // If single char multiescape
-                out += jschar_multiescape(src[i]);
+            i += ascii_run(src.data() + i, src.size() - i);
+            if (i == src.size()) return true;
+            char32_t code_point;
+            const size_t length = utf8_decode(src.substr(i), code_point);
+            if (!length) return false;
+            i += length;
+        }
+        return true;
+    }
+    // Writes \uXXXX, code points past the BMP become a surrogate pair
+    inline void jschar_sequence_escape(std::string& out, char32_t c) {
+        constexpr const char* hex = "0123456789abcdef";
+        if (c > 0xffff) {
+            c -= 0x10000;
+            jschar_sequence_escape(out, 0xd800 + (c >> 10));
+            return jschar_sequence_escape(out, 0xdc00 + (c & 0x3ff));
+        }
+        out += {'\\', 'u', hex[(c >> 12) & 15], hex[(c >> 8) & 15], hex[(c >> 4) & 15], hex[c & 15]};
+    }
+    /*
+        Appends so writers don't build a temporary per string
+        Plain runs are found a vector at a time and copied whole, valid UTF-8 goes through as is unless ascii_only is set,
+        lone surrogates go back to \uXXXX and invalid bytes are escaped as if they were latin-1 so the output is always valid JSON
+    */
+    inline void jsstring_escape(std::string& out, std::string_view src, bool ascii_only = false) {
+        out += '"';
+        for (size_t i = 0; i < src.size();) {
+            const size_t plain = plain_string_run(src.data() + i, src.size() - i);
+            out.append(src.data() + i, plain);
+            i += plain;
+            if (i == src.size()) break;
+            const auto c = uint8_t(src[i]);
+            if (const char k = escape_table[c]) {
+                out += {'\\', k};
                 i++;
-            } else {
-                // If multiescape
-                out += jschar_multiescape(src[i], src[i + 1]);
-                i += 2;
+                continue;
             }
+            char32_t code_point = c;
+            size_t length = 1;
+            if (c >= 0x80) {
+                length = utf8_decode(src.substr(i), code_point);
+                if (!length && !(length = wtf8_surrogate(src.substr(i), code_point))) {
+                    code_point = c;
+                    length = 1;
+                } else if (!ascii_only && !is_high_surrogate(code_point) && !is_low_surrogate(code_point)) {
+                    out.append(src.data() + i, length);
+                    i += length;
+                    continue;
+                }
+            }
+            jschar_sequence_escape(out, code_point);
+            i += length;
         }
-        out += "\"";
+        out += '"';
+    }
+    inline std::string jsstring_escape(std::string_view src, bool ascii_only = false) {
+        std::string out;
+        jsstring_escape(out, src, ascii_only);
         return out;
     }
 
-    // This way unnecessary 0's aren't added
+    // This way unnecessary 0's aren't added, same output as streaming a double with the default precision
+    inline void num_to_string(std::string& out, double x) {
+        char buffer[32];
+        const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), x, std::chars_format::general, 6);
+        out.append(buffer, end);
+    }
     inline std::string num_to_string(double x) {
-        std::ostringstream oss;
-        oss << x;
-        return oss.str();
+        std::string out;
+        num_to_string(out, x);
+        return out;
     }
-    inline bool is_valid_number(const std::string& src) {
+    inline bool is_valid_number(std::string_view src) {
         double value;
         auto [ptr, ec] = std::from_chars(src.data(), src.data() + src.size(), value);
         return ec == std::errc() && ptr == src.data() + src.size();
     }
-    inline bool is_valid_integer(const std::string& src, int base = 10) {
+    // Locale independent, and values out of range saturate like strtod
+    inline double to_double(std::string_view src) {
+        double value = 0;
+        auto [ptr, ec] = std::from_chars(src.data(), src.data() + src.size(), value);
+        if (ec == std::errc::result_out_of_range) {
+            const auto exponent = src.find_first_of("eE");
+            const bool tiny = exponent != std::string_view::npos && src.substr(exponent + 1).starts_with('-');
+            value = tiny ? 0.0 : std::numeric_limits<double>::infinity();
+            return src.starts_with('-') ? -value : value;
+        }
+        return value;
+    }
+    // Digits of the mantissa without leading zeros
+    inline size_t significant_digits(std::string_view src) {
+        size_t digits = 0;
+        for (char c : src) {
+            if (c == 'e' || c == 'E') break;
+            if (c >= '1' && c <= '9') digits++;
+            else if (c == '0' && digits) digits++;
+        }
+        return digits;
+    }
+    // How a number is stored, see parse_number()
+    enum class NumberKind : uint8_t {
+        Integer,
+        Unsigned, // Only above the range of Integer
+        Double,
+        Raw, // Kept as text, only with raw numbers on
+    };
+    struct ParsedNumber {
+        NumberKind kind;
+        union {
+            int64_t integer;
+            uint64_t uinteger;
+            double number;
+        };
+    };
+    /*
+        Sorts a number's text the way parsed values store it, integers stay exact when they fit in 64 bits
+        and with raw_numbers whatever a double can't hold without losing digits stays text
+        Throws if it isn't a valid number, this is the only place numbers are parsed from text
+    */
+    inline ParsedNumber parse_number(std::string_view src, bool raw_numbers) {
+        const auto begin = src.data();
+        const auto end = src.data() + src.size();
+        ParsedNumber out;
+        if (src != "-0") { // Would lose its sign as an integer
+            auto [ptr, ec] = std::from_chars(begin, end, out.integer);
+            if (ptr == end && ec == std::errc()) {
+                out.kind = NumberKind::Integer;
+                return out;
+            }
+            if (ptr == end && ec == std::errc::result_out_of_range) {
+                auto [uptr, uec] = std::from_chars(begin, end, out.uinteger);
+                if (uptr == end && uec == std::errc()) {
+                    out.kind = NumberKind::Unsigned;
+                    return out;
+                }
+                if (raw_numbers) {
+                    out.kind = NumberKind::Raw;
+                    return out;
+                }
+            }
+        }
+        auto [ptr, ec] = std::from_chars(begin, end, out.number);
+        const bool out_of_range = ec == std::errc::result_out_of_range;
+        if (ptr != end || (ec != std::errc() && !(out_of_range && raw_numbers)))
+            throw sjson_parse_error::invalid_token("number", src);
+        out.kind = raw_numbers && (out_of_range || significant_digits(src) > std::numeric_limits<double>::digits10) ? NumberKind::Raw : NumberKind::Double;
+        return out;
+    }
+    inline bool is_valid_integer(std::string_view src, int base = 10) {
         uint64_t value;
         auto [ptr, ec] = std::from_chars(src.data(), src.data() + src.size(), value, base);
         return ec == std::errc() && ptr == src.data() + src.size();
     }
 
-    inline std::string hex_to_UTF8(const std::string_view& hex) {
-        uint16_t value;
-        std::from_chars(hex.data(), hex.data() + hex.size(), value, 16);
-        return std::string(reinterpret_cast<char*>(&value), 2);
+    inline void utf8_encode(std::string& out, char32_t c) {
+        if (c < 0x80) {
+            out += char(c);
+        } else if (c < 0x800) {
+            out += {char(0xc0 | (c >> 6)), char(0x80 | (c & 0x3f))};
+        } else if (c < 0x10000) {
+            out += {char(0xe0 | (c >> 12)), char(0x80 | ((c >> 6) & 0x3f)), char(0x80 | (c & 0x3f))};
+        } else {
+            out += {char(0xf0 | (c >> 18)), char(0x80 | ((c >> 12) & 0x3f)), char(0x80 | ((c >> 6) & 0x3f)), char(0x80 | (c & 0x3f))};
+        }
     }
 
     /*
@@ -89,6 +245,9 @@ namespace SJSON {
             if (empty()) throw sjson_internal_parse_error::vector_stack("Call to pop() while empty");
             vec.pop_back();
         }
+        inline constexpr void clear() noexcept {
+            vec.clear(); // Capacity stays for the next use
+        }
         inline constexpr size_t size() const noexcept {
             return vec.size();
         }
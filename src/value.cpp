@@ -1,136 +1,257 @@
 #include "value.hpp"
 #include "util.hpp"
-#include <sstream>
+#include "writer.hpp"
+#include <cstring>
+#include <limits>
 #include <string>
 #include <string_view>
 #include <variant>
 
 namespace SJSON {
+    namespace {
+        template <typename T, typename... Args>
+        T* make_box(std::pmr::memory_resource* resource, Args&&... args) {
+            return std::pmr::polymorphic_allocator<>(resource).new_object<T>(std::forward<Args>(args)...);
+        }
+        // Boxes are freed into the resource their contents use
+        void free_box(JSString* v) { std::pmr::polymorphic_allocator<>(v->get_allocator().resource()).delete_object(v); }
+        void free_box(JSRawNumber* v) { std::pmr::polymorphic_allocator<>(v->src.get_allocator().resource()).delete_object(v); }
+        void free_box(JSObject* v) { std::pmr::polymorphic_allocator<>(v->resource()).delete_object(v); }
+        void free_box(JSArray* v) { std::pmr::polymorphic_allocator<>(v->get_allocator().resource()).delete_object(v); }
+    } // namespace
+
     JSValue::JSValue(JSNull v):
         SJSON::JSValue() {} // Call default constructor instead
-    JSValue::JSValue(JSNumber v):
-        src(v) {}
+    JSValue::JSValue(JSNumber v) {
+        set(Kind::Number, v);
+    }
     // Fix constructor issues for integral constants
-    JSValue::JSValue(int v):
-        src(JSNumber(v)) {}
-    JSValue::JSValue(long v):
-        src(JSNumber(v)) {}
+    JSValue::JSValue(int v) {
+        set(Kind::Integer, JSInteger(v));
+    }
+    JSValue::JSValue(long v) {
+        set(Kind::Integer, JSInteger(v));
+    }
+    JSValue::JSValue(long long v) {
+        set(Kind::Integer, JSInteger(v));
+    }
+    JSValue::JSValue(unsigned v) {
+        set(Kind::Integer, JSInteger(v));
+    }
+    // Unsigned is only for what doesn't fit in a JSInteger, same as parsed numbers
     JSValue::JSValue(unsigned long v):
-        src(JSNumber(v)) {}
-    JSValue::JSValue(JSBoolean v):
-        src(v) {}
-    JSValue::JSValue(JSString v):
-        src(std::move(v)) {}
-    JSValue::JSValue(std::string_view v):
-        src(JSString(std::move(v))) {}
+        JSValue((unsigned long long)v) {}
+    JSValue::JSValue(unsigned long long v) {
+        if (v <= uint64_t(std::numeric_limits<JSInteger>::max()))
+            set(Kind::Integer, JSInteger(v));
+        else
+            set(Kind::Unsigned, JSUnsigned(v));
+    }
+    JSValue::JSValue(JSRawNumber v) {
+        set(Kind::RawNumber, make_box<JSRawNumber>(v.src.get_allocator().resource(), std::move(v)));
+    }
+    JSValue::JSValue(JSBoolean v) {
+        set(Kind::Boolean, v);
+    }
+    JSValue::JSValue(JSString v) {
+        if (v.size() <= small_string_capacity)
+            *this = JSValue(std::string_view(v));
+        else
+            set(Kind::String, make_box<JSString>(v.get_allocator().resource(), std::move(v)));
+    }
+    JSValue::JSValue(std::string_view v, std::pmr::memory_resource* resource) {
+        if (v.size() > small_string_capacity) {
+            set(Kind::String, make_box<JSString>(resource, v));
+            return;
+        }
+        std::memcpy(storage, v.data(), v.size());
+        small_size = uint8_t(v.size());
+        kind = Kind::SmallString;
+    }
     JSValue::JSValue(const char* v):
-        src(JSString(v)) {}
-    JSValue::JSValue(JSObject v):
-        src(std::move(v)) {}
-    JSValue::JSValue(JSArray v):
-        src(std::move(v)) {}
+        JSValue(std::string_view(v)) {}
+    JSValue::JSValue(JSObject v) {
+        set(Kind::Object, make_box<JSObject>(v.resource(), std::move(v)));
+    }
+    JSValue::JSValue(JSArray v) {
+        set(Kind::Array, make_box<JSArray>(v.get_allocator().resource(), std::move(v)));
+    }
+    JSValue::JSValue(const JSValue& v) {
+        const auto resource = std::pmr::get_default_resource();
+        switch (v.kind) {
+            case Kind::String: set(v.kind, make_box<JSString>(resource, *v.get<JSString*>())); break;
+            case Kind::RawNumber: set(v.kind, make_box<JSRawNumber>(resource, JSRawNumber {JSString(v.get<JSRawNumber*>()->src, resource)})); break;
+            case Kind::Object: set(v.kind, make_box<JSObject>(resource, *v.get<JSObject*>())); break;
+            case Kind::Array: set(v.kind, make_box<JSArray>(resource, *v.get<JSArray*>())); break;
+            default:
+                std::memcpy(storage, v.storage, sizeof(storage));
+                small_size = v.small_size;
+                kind = v.kind;
+        }
+    }
+    JSValue& JSValue::operator=(const JSValue& v) {
+        if (this != &v) *this = JSValue(v);
+        return *this;
+    }
+    JSValue::JSValue(JSValue&& v) noexcept {
+        std::memcpy(storage, v.storage, sizeof(storage));
+        small_size = v.small_size;
+        kind = v.kind;
+        v.kind = Kind::Null;
+    }
+    // Moving into a temporary first so assigning a child of this value to it is fine
+    JSValue& JSValue::operator=(JSValue&& v) noexcept {
+        if (this == &v) return *this;
+        JSValue moved(std::move(v));
+        release();
+        std::memcpy(storage, moved.storage, sizeof(storage));
+        small_size = moved.small_size;
+        kind = moved.kind;
+        moved.kind = Kind::Null;
+        return *this;
+    }
+    JSValue::~JSValue() {
+        release();
+    }
+
+    void JSValue::release() noexcept {
+        switch (kind) {
+            case Kind::String: free_box(get<JSString*>()); break;
+            case Kind::RawNumber: free_box(get<JSRawNumber*>()); break;
+            case Kind::Object: free_box(get<JSObject*>()); break;
+            case Kind::Array: free_box(get<JSArray*>()); break;
+            default: break;
+        }
+        kind = Kind::Null;
+    }
+    // Keeps the old variant behaviour of throwing on the wrong type
+    void JSValue::expect(Kind k) const {
+        if (kind != k) throw std::bad_variant_access();
+    }
 
     JSValueType JSValue::type() const {
-        return std::visit([](const auto& v) -> JSValueType {
-            using V = std::decay_t<decltype(v)>;
-            if constexpr (std::is_same_v<V, JSNull>) return JSValueType::Null;
-            if constexpr (std::is_same_v<V, JSNumber>) return JSValueType::Number;
-            if constexpr (std::is_same_v<V, JSBoolean>) return JSValueType::Boolean;
-            if constexpr (std::is_same_v<V, JSString>) return JSValueType::String;
-            if constexpr (std::is_same_v<V, JSObject>) return JSValueType::Object;
-            if constexpr (std::is_same_v<V, JSArray>) return JSValueType::Array;
-        },
-            src);
+        switch (kind) {
+            case Kind::Null: return JSValueType::Null;
+            case Kind::Number:
+            case Kind::Integer:
+            case Kind::Unsigned:
+            case Kind::RawNumber: return JSValueType::Number;
+            case Kind::Boolean: return JSValueType::Boolean;
+            case Kind::SmallString:
+            case Kind::String: return JSValueType::String;
+            case Kind::Object: return JSValueType::Object;
+            case Kind::Array: return JSValueType::Array;
+        }
+        return JSValueType::Null;
     }
     const char* JSValue::type_str() const noexcept {
         return type_to_string(type());
     }
     bool JSValue::is_null() const noexcept {
-        return std::holds_alternative<JSNull>(src);
+        return kind == Kind::Null;
     }
     bool JSValue::is_number() const noexcept {
-        return std::holds_alternative<JSNumber>(src);
+        return kind == Kind::Number || is_integer() || is_raw_number();
+    }
+    bool JSValue::is_integer() const noexcept {
+        return kind == Kind::Integer || kind == Kind::Unsigned;
+    }
+    bool JSValue::is_raw_number() const noexcept {
+        return kind == Kind::RawNumber;
     }
     bool JSValue::is_boolean() const noexcept {
-        return std::holds_alternative<JSBoolean>(src);
+        return kind == Kind::Boolean;
     }
     bool JSValue::is_string() const noexcept {
-        return std::holds_alternative<JSString>(src);
+        return kind == Kind::SmallString || kind == Kind::String;
     }
     bool JSValue::is_object() const noexcept {
-        return std::holds_alternative<JSObject>(src);
+        return kind == Kind::Object;
     }
     bool JSValue::is_array() const noexcept {
-        return std::holds_alternative<JSArray>(src);
+        return kind == Kind::Array;
     }
     std::string JSValue::to_string(int index_length, int index) const {
-        return std::visit([&](const auto& v) -> std::string {
-            using V = std::decay_t<decltype(v)>;
-            if constexpr (std::is_same_v<V, JSNull>) return "null";
-            if constexpr (std::is_same_v<V, JSNumber>) return num_to_string(v);
-            if constexpr (std::is_same_v<V, JSBoolean>) return v ? "true" : "false";
-            if constexpr (std::is_same_v<V, JSString>) return jsstring_escape(v);
-            if constexpr (std::is_same_v<V, JSObject> || std::is_same_v<V, JSArray>) {
-                // Most of this logic is the same for objects and arrays with slight differences
-                constexpr bool is_obj = std::is_same_v<V, JSObject>;
-                constexpr char start_char = is_obj ? '{' : '[';
-                constexpr char end_char = is_obj ? '}' : ']';
-                if (!v.size()) return std::string {start_char, end_char};
-                const auto el_index = std::string(index * index_length, ' ');
-                const auto base_index = std::string((index - 1) * index_length, ' ');
-                const char* newline = index_length ? "\n" : "";
-                const char* space = index_length ? " " : "";
-                bool is_first = true;
-                std::stringstream ss;
-                for (const auto& el : v) {
-                    ss << (is_first ? start_char : ',') << newline << el_index;
-                    if constexpr (is_obj)
-                        ss << jsstring_escape(el.first) << ":" << space << el.second.to_string(index_length, index + 1);
-                    else
-                        ss << el.to_string(index_length, index + 1);
-                    is_first = false;
-                }
-                ss << newline << base_index << end_char;
-                return ss.str();
-            }
-        },
-            src);
+        std::string out;
+        Writer(out, index_length).write(*this, index - 1);
+        return out;
     }
 
     JSNull& JSValue::null() {
-        return std::get<JSNull>(src);
+        static JSNull v;
+        expect(Kind::Null);
+        return v;
+    }
+    JSInteger& JSValue::integer() {
+        expect(Kind::Integer);
+        return get<JSInteger>();
     }
-    JSNumber& JSValue::number() {
-        return std::get<JSNumber>(src);
+    JSUnsigned& JSValue::unsigned_integer() {
+        expect(Kind::Unsigned);
+        return get<JSUnsigned>();
+    }
+    JSRawNumber& JSValue::raw_number() {
+        expect(Kind::RawNumber);
+        return *get<JSRawNumber*>();
     }
     JSBoolean& JSValue::boolean() {
-        return std::get<JSBoolean>(src);
+        expect(Kind::Boolean);
+        return get<JSBoolean>();
     }
-    JSString& JSValue::string() {
-        return std::get<JSString>(src);
+    JSString& JSValue::string(std::pmr::memory_resource* resource) {
+        if (kind == Kind::SmallString) set(Kind::String, make_box<JSString>(resource, std::string_view(storage, small_size)));
+        expect(Kind::String);
+        return *get<JSString*>();
     }
     JSObject& JSValue::object() {
-        return std::get<JSObject>(src);
+        expect(Kind::Object);
+        return *get<JSObject*>();
     }
     JSArray& JSValue::array() {
-        return std::get<JSArray>(src);
+        expect(Kind::Array);
+        return *get<JSArray*>();
     }
     const JSNull& JSValue::null() const {
-        return std::get<JSNull>(src);
+        return const_cast<JSValue*>(this)->null();
+    }
+    JSNumber JSValue::number() const {
+        switch (kind) {
+            case Kind::Integer: return JSNumber(get<JSInteger>());
+            case Kind::Unsigned: return JSNumber(get<JSUnsigned>());
+            case Kind::RawNumber: return to_double(get<JSRawNumber*>()->src);
+            default: expect(Kind::Number); return get<JSNumber>();
+        }
     }
-    const JSNumber& JSValue::number() const {
-        return std::get<JSNumber>(src);
+    const JSInteger& JSValue::integer() const {
+        expect(Kind::Integer);
+        return get<JSInteger>();
+    }
+    const JSUnsigned& JSValue::unsigned_integer() const {
+        expect(Kind::Unsigned);
+        return get<JSUnsigned>();
+    }
+    const JSRawNumber& JSValue::raw_number() const {
+        expect(Kind::RawNumber);
+        return *get<JSRawNumber*>();
     }
     const JSBoolean& JSValue::boolean() const {
-        return std::get<JSBoolean>(src);
+        expect(Kind::Boolean);
+        return get<JSBoolean>();
+    }
+    std::string_view JSValue::string() const {
+        return string_view();
     }
-    const JSString& JSValue::string() const {
-        return std::get<JSString>(src);
+    std::string_view JSValue::string_view() const {
+        if (kind == Kind::SmallString) return std::string_view(storage, small_size);
+        expect(Kind::String);
+        return *get<JSString*>();
     }
     const JSObject& JSValue::object() const {
-        return std::get<JSObject>(src);
+        expect(Kind::Object);
+        return *get<JSObject*>();
     }
     const JSArray& JSValue::array() const {
-        return std::get<JSArray>(src);
+        expect(Kind::Array);
+        return *get<JSArray*>();
     }
 } // namespace SJSON
@@ -1,5 +1,10 @@
 #pragma once
-#include <map>
+#include "object.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
 #include <ostream>
 #include <string>
 #include <string_view>
@@ -10,18 +15,14 @@ namespace SJSON {
     class JSValue;
     typedef std::monostate JSNull;
     typedef double JSNumber;
+    typedef int64_t JSInteger;
+    typedef uint64_t JSUnsigned; // Only used for integers above the range of JSInteger
     typedef bool JSBoolean;
-    typedef std::string JSString;
-    typedef std::map<std::string, JSValue> JSObject; // Ordering is important for JavaScript for some reason
-    typedef std::vector<JSValue> JSArray;
-    using JSValueData = std::variant<
-        JSNull,
-        JSNumber,
-        JSBoolean,
-        JSString,
-        JSObject,
-        JSArray>;
-
+    typedef std::pmr::vector<JSValue> JSArray;
+    // Decimal text of a number that doesn't fit in a JSNumber or JSInteger without losing digits
+    struct JSRawNumber {
+        JSString src;
+    };
     enum class JSValueType {
         Null,
         Number,
@@ -31,9 +32,49 @@ namespace SJSON {
         Array,
     };
 
+    /*
+        Compact 16 byte value
+        Scalars live inline, strings up to small_string_capacity chars too, everything else is boxed
+        in the memory resource it was made with so arrays of small scalars stay small
+    */
     class JSValue {
+    public:
+        inline static constexpr size_t small_string_capacity = 14;
+
     private:
-        JSValueData src;
+        friend class Writer;
+        friend class CBORWriter;
+        enum class Kind : uint8_t {
+            Null,
+            Number,
+            Integer,
+            Unsigned,
+            Boolean,
+            SmallString,
+            String,
+            RawNumber,
+            Object,
+            Array,
+        };
+        alignas(8) char storage[small_string_capacity] {};
+        uint8_t small_size = 0;
+        Kind kind = Kind::Null;
+
+        template <typename T>
+        inline T& get() noexcept {
+            return *std::launder(reinterpret_cast<T*>(storage));
+        }
+        template <typename T>
+        inline const T& get() const noexcept {
+            return *std::launder(reinterpret_cast<const T*>(storage));
+        }
+        template <typename T>
+        inline void set(Kind k, T v) noexcept {
+            std::construct_at(reinterpret_cast<T*>(storage), v);
+            kind = k;
+        }
+        void expect(Kind k) const;
+        void release() noexcept;
 
     public:
         JSValue() = default;
@@ -42,20 +83,30 @@ namespace SJSON {
         JSValue(JSNumber v);
         JSValue(int v);
         JSValue(long v);
+        JSValue(long long v);
+        JSValue(unsigned v);
         JSValue(unsigned long v);
+        JSValue(unsigned long long v);
+        JSValue(JSRawNumber v);
         JSValue(JSBoolean v);
         JSValue(JSString v);
-        JSValue(std::string_view v);
+        JSValue(std::string_view v, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
         JSValue(const char* v);
         JSValue(JSObject v);
         JSValue(JSArray v);
-        ~JSValue() = default;
+        JSValue(const JSValue& v); // Copies use the default memory resource
+        JSValue& operator=(const JSValue& v);
+        JSValue(JSValue&& v) noexcept; // Moves keep the memory resource
+        JSValue& operator=(JSValue&& v) noexcept;
+        ~JSValue();
 
         // Non-type specific
         JSValueType type() const;
         const char* type_str() const noexcept;
         bool is_null() const noexcept;
         bool is_number() const noexcept;
+        bool is_integer() const noexcept; // Numbers stored exactly as a JSInteger or JSUnsigned
+        bool is_raw_number() const noexcept;
         bool is_boolean() const noexcept;
         bool is_string() const noexcept;
         bool is_object() const noexcept;
@@ -64,15 +115,21 @@ namespace SJSON {
 
         // Type specific
         JSNull& null();
-        JSNumber& number();
+        JSInteger& integer();
+        JSUnsigned& unsigned_integer();
+        JSRawNumber& raw_number();
         JSBoolean& boolean();
-        JSString& string();
+        JSString& string(std::pmr::memory_resource* resource = std::pmr::get_default_resource()); // Short strings are boxed in resource the first time
         JSObject& object();
         JSArray& array();
         const JSNull& null() const;
-        const JSNumber& number() const;
+        JSNumber number() const; // Any number converted to a JSNumber, the value itself is never changed
+        const JSInteger& integer() const;
+        const JSUnsigned& unsigned_integer() const;
+        const JSRawNumber& raw_number() const;
         const JSBoolean& boolean() const;
-        const JSString& string() const;
+        std::string_view string() const; // Never boxes, same as string_view()
+        std::string_view string_view() const;
         const JSObject& object() const;
         const JSArray& array() const;
 
@@ -81,6 +138,48 @@ namespace SJSON {
             return out << v.to_string(4);
         }
     };
+    static_assert(sizeof(JSValue) == 16);
+
+    // A contiguous member, the union keeps its lifetime in the slot's hands so it can be rebuilt in place
+    struct JSObject::Slot {
+        union {
+            value_type value;
+        };
+
+        inline Slot(JSKey&& key, JSValue&& v) noexcept { std::construct_at(&value, std::move(key), std::move(v)); }
+        inline Slot(const Slot& v) { std::construct_at(&value, v.value); }
+        // The key is const so another handle to it is taken, which never allocates
+        inline Slot(Slot&& v) noexcept { std::construct_at(&value, v.value.first.share(), std::move(v.value.second)); }
+        inline Slot& operator=(const Slot& v) {
+            if (this != &v) *this = Slot(v);
+            return *this;
+        }
+        inline Slot& operator=(Slot&& v) noexcept {
+            if (this == &v) return *this;
+            std::destroy_at(&value);
+            std::construct_at(&value, v.value.first.share(), std::move(v.value.second));
+            return *this;
+        }
+        inline ~Slot() { std::destroy_at(&value); }
+    };
+
+    /*
+        Monotonic arena for a whole document
+        Parsing with it turns thousands of small allocations into a few large blocks that are all freed at once
+        when the arena goes out of scope, so values allocated from it must not outlive it
+    */
+    class Arena : public std::pmr::monotonic_buffer_resource {
+    public:
+        inline static constexpr size_t default_block_size = 64 * 1024;
+
+        inline Arena(size_t block_size = default_block_size):
+            std::pmr::monotonic_buffer_resource(block_size) {}
+        inline Arena(size_t block_size, std::pmr::memory_resource* upstream):
+            std::pmr::monotonic_buffer_resource(block_size, upstream) {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena() = default;
+    };
 
     // Static debug shit
     inline constexpr const char* type_to_string(JSValueType type) noexcept {
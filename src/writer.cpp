@@ -0,0 +1,167 @@
+#include "writer.hpp"
+#include "util.hpp"
+#include <cerrno>
+#include <charconv>
+#include <system_error>
+#include <unistd.h>
+
+namespace SJSON {
+    Writer::Writer(JSONSink sink, int index_length, size_t block_size):
+        sink(std::move(sink)),
+        buffer(&own_buffer),
+        block_size(block_size ? block_size : default_block_size),
+        index_length(index_length) {
+        own_buffer.reserve(this->block_size);
+    }
+    Writer::Writer(std::string& out, int index_length):
+        buffer(&out),
+        block_size(0),
+        index_length(index_length) {}
+    // The buffer pointer has to follow own_buffer
+    Writer::Writer(Writer&& v) noexcept:
+        sink(std::move(v.sink)),
+        own_buffer(std::move(v.own_buffer)),
+        buffer(v.buffer == &v.own_buffer ? &own_buffer : v.buffer),
+        block_size(v.block_size),
+        index_length(v.index_length),
+        ascii_only(v.ascii_only),
+        indents(std::move(v.indents)),
+        stack(std::move(v.stack)) {}
+    Writer& Writer::operator=(Writer&& v) noexcept {
+        if (this == &v) return *this;
+        try {
+            flush();
+        } catch (...) {}
+        sink = std::move(v.sink);
+        own_buffer = std::move(v.own_buffer);
+        buffer = v.buffer == &v.own_buffer ? &own_buffer : v.buffer;
+        block_size = v.block_size;
+        index_length = v.index_length;
+        ascii_only = v.ascii_only;
+        indents = std::move(v.indents);
+        stack = std::move(v.stack);
+        return *this;
+    }
+    // Whatever's left goes out, errors here have nowhere to go
+    Writer::~Writer() {
+        try {
+            flush();
+        } catch (...) {}
+    }
+
+    Writer Writer::fd(int fd, int index_length, size_t block_size) {
+        return Writer([fd](std::string_view chunk) {
+            while (!chunk.empty()) {
+                const auto written = ::write(fd, chunk.data(), chunk.size());
+                if (written < 0) {
+                    if (errno == EINTR) continue;
+                    throw std::system_error(errno, std::generic_category(), "Writer::fd()");
+                }
+                chunk.remove_prefix(size_t(written));
+            }
+        },
+            index_length, block_size);
+    }
+    std::string Writer::to_string(const JSValue& value, int index_length) {
+        std::string out;
+        Writer(out, index_length).write(value);
+        return out;
+    }
+
+    void Writer::newline(size_t depth) {
+        if (!index_length) return;
+        const size_t length = depth * index_length;
+        if (indents.size() < length) indents.resize(length * 2, ' ');
+        *buffer += '\n';
+        buffer->append(indents.data(), length);
+    }
+    void Writer::scalar(const JSValue& value) {
+        using Kind = JSValue::Kind;
+        char digits[24];
+        switch (value.kind) {
+            case Kind::Null: *buffer += "null"; break;
+            case Kind::Number: num_to_string(*buffer, value.get<JSNumber>()); break;
+            case Kind::Integer: buffer->append(digits, std::to_chars(digits, digits + sizeof(digits), value.get<JSInteger>()).ptr); break;
+            case Kind::Unsigned: buffer->append(digits, std::to_chars(digits, digits + sizeof(digits), value.get<JSUnsigned>()).ptr); break;
+            case Kind::RawNumber: *buffer += value.get<JSRawNumber*>()->src; break;
+            case Kind::Boolean: *buffer += value.get<JSBoolean>() ? "true" : "false"; break;
+            case Kind::SmallString:
+            case Kind::String: jsstring_escape(*buffer, value.string_view(), ascii_only); break;
+            case Kind::Object:
+            case Kind::Array: break;
+        }
+    }
+    // Containers that aren't empty get a frame, the rest are written straight away
+    void Writer::open(const JSValue& value) {
+        if (value.is_object()) {
+            if (value.object().empty()) {
+                *buffer += "{}";
+                return;
+            }
+            *buffer += '{';
+            stack.push_back(Frame {&value, value.object().begin()});
+        } else if (value.is_array()) {
+            if (value.array().empty()) {
+                *buffer += "[]";
+                return;
+            }
+            *buffer += '[';
+            stack.push_back(Frame {&value});
+        } else {
+            scalar(value);
+        }
+    }
+    void Writer::flush_blocks() {
+        if (!sink || buffer->size() < block_size) return;
+        const size_t blocks = buffer->size() / block_size * block_size;
+        sink(std::string_view(*buffer).substr(0, blocks));
+        buffer->erase(0, blocks);
+    }
+
+    Writer& Writer::ascii(bool enabled) {
+        ascii_only = enabled;
+        return *this;
+    }
+    Writer& Writer::write(const JSValue& value, size_t depth) {
+        stack.clear();
+        open(value);
+        while (!stack.empty()) {
+            auto& frame = stack.back();
+            const size_t level = depth + stack.size();
+            const bool is_obj = frame.container->is_object();
+            const bool done = is_obj ? frame.member == frame.container->object().end() : frame.element == frame.container->array().size();
+            if (done) {
+                newline(level - 1);
+                *buffer += is_obj ? '}' : ']';
+                stack.pop_back();
+                continue;
+            }
+            if (!frame.first) *buffer += ',';
+            frame.first = false;
+            newline(level);
+            const JSValue* child;
+            if (is_obj) {
+                jsstring_escape(*buffer, frame.member->first, ascii_only);
+                *buffer += index_length ? ": " : ":";
+                child = &frame.member->second;
+                ++frame.member;
+            } else {
+                child = &frame.container->array()[frame.element++];
+            }
+            open(*child); // Can push a frame so frame isn't used after this
+            flush_blocks();
+        }
+        flush_blocks();
+        return *this;
+    }
+    Writer& Writer::raw(std::string_view text) {
+        buffer->append(text);
+        flush_blocks();
+        return *this;
+    }
+    void Writer::flush() {
+        if (!sink || buffer->empty()) return;
+        sink(*buffer);
+        buffer->clear();
+    }
+} // namespace SJSON
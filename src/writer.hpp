@@ -0,0 +1,60 @@
+#pragma once
+#include "value.hpp"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SJSON {
+    typedef std::move_only_function<void(std::string_view chunk)> JSONSink;
+
+    /*
+        Iterative serializer
+        Containers are walked with an explicit stack so deep documents can't blow the call stack, and output goes
+        into one reusable buffer that's handed to the sink in fixed size blocks instead of being built up whole
+    */
+    class Writer {
+    protected:
+        // A container that's still being written
+        struct Frame {
+            const JSValue* container;
+            JSObject::const_iterator member;
+            size_t element = 0;
+            bool first = true;
+        };
+        JSONSink sink;
+        std::string own_buffer;
+        std::string* buffer; // Either own_buffer or one the caller gave
+        size_t block_size;
+        int index_length;
+        bool ascii_only = false;
+        std::string indents;
+        std::vector<Frame> stack;
+
+        void newline(size_t depth);
+        void scalar(const JSValue& value);
+        void open(const JSValue& value);
+        void flush_blocks();
+
+    public:
+        inline static constexpr size_t default_block_size = 64 * 1024;
+
+        // Pretty prints when index_length (spaces per level) isn't 0
+        Writer(JSONSink sink, int index_length = 0, size_t block_size = default_block_size);
+        Writer(std::string& out, int index_length = 0); // Appends to out and never flushes it
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        Writer(Writer&& v) noexcept;
+        Writer& operator=(Writer&& v) noexcept;
+        ~Writer();
+
+        static Writer fd(int fd, int index_length = 0, size_t block_size = default_block_size); // Flushes with write(2)
+        static std::string to_string(const JSValue& value, int index_length = 0);
+
+        Writer& ascii(bool enabled = true); // Escape everything past ASCII as \\uXXXX instead of writing UTF-8 as is
+        Writer& write(const JSValue& value, size_t depth = 0); // Depth is where the indentation starts
+        Writer& raw(std::string_view text);                    // Appends text as is, separators between documents for example
+        void flush();                                          // Hands everything buffered to the sink
+    };
+} // namespace SJSON